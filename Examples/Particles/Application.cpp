@@ -97,11 +97,11 @@ Application::Application(int width, int height) : m_window(width, height),
 
     m_particles = std::make_unique<Particles>(100);
 
-    m_particles->setEmitter([](const auto &spawn_pos)
+    m_particles->setEmitter([](const auto &spawn_pos, utils::Rng &rng)
                             {
         Particle p;
         p.pos = spawn_pos;
-        p.vel = {randf(-50, 50), randf(-50, 50)};
+        p.vel = {rng.uniform(-50, 50), rng.uniform(-50, 50)};
         p.acc = 0.5f * p.vel / utils::norm(p.vel); 
         p.scale = 20.;
         p.life_time = 1.f;
@@ -23,6 +23,10 @@ function(set_target_compiler_flags target_name)
     "-sASYNCIFY=1"
     "-sEXCEPTION_CATCHING_ALLOWED=yes" 
     )
+
+    if(USE_WASM_SIMD)
+    target_compile_options(${target_name} PUBLIC "-msimd128")
+    endif()
   endif()
 
 
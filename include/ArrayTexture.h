@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <filesystem>
+
+//! \class ArrayTexture
+//! \brief a GL_TEXTURE_2D_ARRAY holding many images of the same size in separate layers
+//!  Sprites using different layers of the same ArrayTexture end up in one batch and are drawn by a single instanced call,
+//!  the layer is sent per instance (SpriteInstance::texture_layer). Draw them with the "SpriteArrayDefault" shader.
+//!  Layers are always stored as 8-bit RGBA, the options only decide filtering, wrapping and mipmaps
+class ArrayTexture
+{
+public:
+    ArrayTexture() = default;
+    ArrayTexture(int width, int height, int max_layers_count, TextureOptions options = {});
+    ~ArrayTexture();
+
+    ArrayTexture(const ArrayTexture &other) = delete;
+    ArrayTexture &operator=(const ArrayTexture &other) = delete;
+
+    void create(int width, int height, int max_layers_count, TextureOptions options = {});
+
+    int addLayer(const std::filesystem::path &image_file);
+    int addLayer(const unsigned char *buffer, std::size_t size);
+
+    void bind(int slot = 0);
+    Vec2 getSize() const;
+    int getLayersCount() const;
+    int getMaxLayersCount() const;
+    TextureHandle getHandle() const;
+
+    const TextureOptions &getOptions() const;
+
+private:
+    int uploadLayer(const unsigned char *pixels, int width, int height);
+
+private:
+    GLuint m_texture_handle = 0; //! OpenGL id for texture
+    TextureOptions m_options;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_layers_count = 0;
+    int m_max_layers_count = 0;
+};
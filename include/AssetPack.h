@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+constexpr std::size_t ASSET_PACK_ALIGNMENT = 16; //! every blob in the pack starts at a multiple of this
+constexpr std::uint32_t ASSET_PACK_VERSION = 1;
+
+//! \enum AssetPackFlag
+//! \brief per-entry flags stored in the table of contents
+enum class AssetPackFlag : std::uint32_t
+{
+    None = 0,
+    Lz4 = 1 << 0, //!< blob is an LZ4 block and has to be decompressed before use
+};
+
+//! \class AssetPack
+//! \brief read-only view of a packed archive of resources (textures, fonts, shaders ...)
+//!  the whole file is memory-mapped once and entries are handed out as spans into the mapping,
+//!  so uncompressed entries are never copied. LZ4 entries are decompressed on first access
+//!  and cached inside the pack (this is not thread-safe!)
+//!  The pack has to outlive everything that uses its bytes directly (e.g. a Font loaded via loadFromBytes)
+class AssetPack
+{
+public:
+    //! \struct Entry
+    //! \brief one record of the table of contents
+    struct Entry
+    {
+        std::uint64_t offset = 0;   //!< offset of the blob from the start of the file
+        std::uint64_t size = 0;     //!< size of the blob in the file
+        std::uint64_t raw_size = 0; //!< size after decompression (equals size for uncompressed entries)
+        std::uint32_t flags = 0;    //!< combination of AssetPackFlag values
+
+        bool isCompressed() const;
+    };
+
+public:
+    AssetPack() = default;
+    explicit AssetPack(const std::filesystem::path &pack_path);
+    ~AssetPack();
+
+    AssetPack(const AssetPack &other) = delete;
+    AssetPack &operator=(const AssetPack &other) = delete;
+    AssetPack(AssetPack &&other) noexcept;
+    AssetPack &operator=(AssetPack &&other) noexcept;
+
+    bool open(const std::filesystem::path &pack_path);
+    void close();
+    bool isOpen() const;
+
+    bool contains(const std::string &name) const;
+    std::span<const unsigned char> get(const std::string &name) const;
+    std::string_view getString(const std::string &name) const;
+
+    const std::unordered_map<std::string, Entry> &getEntries() const;
+
+private:
+    bool map(const std::filesystem::path &pack_path);
+    void unmap();
+    bool readTableOfContents();
+
+private:
+    const unsigned char *m_data = nullptr; //!< start of the mapped file
+    std::size_t m_size = 0;                //!< size of the mapped file in bytes
+
+    void *m_file_handle = nullptr;    //!< native handles (only used on Windows)
+    void *m_mapping_handle = nullptr;
+    std::vector<unsigned char> m_owned_bytes; //!< used instead of the mapping on platforms without mmap
+
+    std::unordered_map<std::string, Entry> m_entries;
+    mutable std::unordered_map<std::string, std::vector<unsigned char>> m_decompressed;
+};
+
+//! \class AssetPackWriter
+//! \brief collects files and writes them into the format read by AssetPack
+class AssetPackWriter
+{
+public:
+    void add(const std::string &name, std::vector<unsigned char> bytes, bool compress = false);
+    bool addFile(const std::string &name, const std::filesystem::path &file_path, bool compress = false);
+    std::size_t addDirectory(const std::filesystem::path &directory, bool compress = false);
+
+    bool write(const std::filesystem::path &pack_path) const;
+
+private:
+    struct PendingEntry
+    {
+        std::string name;
+        std::vector<unsigned char> bytes;
+        std::uint64_t raw_size = 0;
+        std::uint32_t flags = 0;
+    };
+
+    std::vector<PendingEntry> m_entries;
+};
+
+std::vector<unsigned char> lz4CompressBlock(const unsigned char *source, std::size_t size);
+bool lz4DecompressBlock(const unsigned char *source, std::size_t size, unsigned char *destination, std::size_t destination_size);
@@ -7,6 +7,7 @@
 #include "GLTypeDefs.h"
 #include "BatchConfig.h"
 #include "VertexArrayObject.h"
+#include "TextureResidency.h"
 
 #include <typeindex>
 #include <unordered_map>
@@ -23,11 +24,12 @@ public:
     BatchI(VAOId layout);
     virtual ~BatchI();
 
-    virtual void flush(View &view, Shader &shader, TextureArray textures) = 0;
+    virtual void flush(View &view, Shader &shader, TextureArray textures, TextureTarget texture_target) = 0;
+    virtual bool isEmpty() const = 0;
 
-public:
     void addVertices(void *vertex_data, std::size_t data_size);
     void addInstance(void *instance_data, std::size_t data_size);
+    void addInstances(const void *instances_data, std::size_t instances_count, std::size_t instance_size);
 
     GLuint initVertexArrayObject(VAOId layout);
 
@@ -51,7 +53,8 @@ class VertexBatch : public BatchI
 public:
     VertexBatch(VAOId layout);
 
-    virtual void flush(View &view, Shader &shader, TextureArray textures) override;
+    virtual void flush(View &view, Shader &shader, TextureArray textures, TextureTarget texture_target) override;
+    virtual bool isEmpty() const override;
     void addVertices(void *data, std::size_t data_size);
 };
 class InstancedBatch : public BatchI
@@ -59,7 +62,8 @@ class InstancedBatch : public BatchI
 public:
     InstancedBatch(std::vector<std::byte> vertex_data, VAOId layout);
 
-    virtual void flush(View &view, Shader &shader, TextureArray textures) override;
+    virtual void flush(View &view, Shader &shader, TextureArray textures, TextureTarget texture_target) override;
+    virtual bool isEmpty() const override;
 };
 
 VAOId makeSpriteVAO();
@@ -74,13 +78,28 @@ struct BatchRegistry
     using BatchMaker = std::function<std::shared_ptr<BatchI>()>;
     using BatchHolder = std::unordered_map<BatchConfig, std::shared_ptr<BatchI>>;
 
-    void renderAll(View &view)
+    //! \param view
+    //! \param blend_params    blending of batches which do not have their own
+    void renderAll(View &view, const BlendParams &blend_params)
     {
         for (auto &batch_holder : m_batches)
         {
             for (auto &[config, batch] : batch_holder)
             {
-                batch->flush(view, *config.p_shader, config.texture_ids);
+                bool own_blending = config.blend_params && !batch->isEmpty();
+                if (!batch->isEmpty())
+                {
+                    TextureResidency::instance().markUsed(config.texture_ids); //! reloads evicted textures before drawing
+                }
+                if (own_blending)
+                {
+                    setBlendParams(*config.blend_params);
+                }
+                batch->flush(view, *config.p_shader, config.texture_ids, config.texture_target);
+                if (own_blending)
+                {
+                    setBlendParams(blend_params);
+                }
             }
         }
     }
@@ -98,6 +117,26 @@ struct BatchRegistry
         m_batches.at(batch_type_id).at(config)->addInstance(&instance, sizeof(T));
     }
 
+    //! \brief copies all \p instances into the batch given by \p config at once
+    template <class T>
+    void pushInstances(const std::vector<T> &instances, BatchConfig config)
+    {
+        pushInstances(instances.data(), instances.size(), config);
+    }
+
+    //! \brief copies \p count instances starting at \p instances into the batch given by \p config at once
+    template <class T>
+    void pushInstances(const T *instances, std::size_t count, BatchConfig config)
+    {
+        auto batch_type_id = m_type2batch_id.at(typeid(T));
+        if (!configExists(config, typeid(T)))
+        {
+            m_batches.at(batch_type_id)[config] = m_batch_makers.at(batch_type_id)();
+        }
+
+        m_batches.at(batch_type_id).at(config)->addInstances(instances, count, sizeof(T));
+    }
+
     template <class T>
     void pushVertex(T vertex, BatchConfig config)
     {
@@ -1,13 +1,16 @@
 #pragma once
 
 #include "GLTypeDefs.h"
+#include "BlendParams.h"
+#include <optional>
 #include <vector>
 
 class Shader;
 
 //! \struct BatchConfig
 //! \brief stores information which define batches
-//! \brief each batch is defined by: 1. a set of GL texture ids 2. GL shader id and GL draw type
+//! \brief each batch is defined by: 1. a set of GL texture ids (and their target) 2. GL shader id and GL draw type
+//! \brief 3. optionally its own blending
 struct BatchConfig
 {
     BatchConfig() = default;
@@ -21,8 +24,10 @@ struct BatchConfig
     TextureArray texture_ids = {};
     GLuint shader_id = 0;
     DrawType draw_type = DrawType::Dynamic;
+    TextureTarget texture_target = TextureTarget::Texture2D; //!< all textures of the batch are bound to this target
 
     Shader* p_shader = nullptr;
+    std::optional<BlendParams> blend_params; //!< blending of the batch, if empty the renderer's blending is used
 };
 
 
@@ -42,7 +47,12 @@ struct std::hash<BatchConfig>
     std::size_t operator()(const BatchConfig &config) const
     {
         std::size_t ret = 0;
-        hash_combine(ret, config.shader_id, config.draw_type, config.texture_ids[0], config.texture_ids[1]);
+        hash_combine(ret, config.shader_id, config.draw_type, config.texture_target, config.texture_ids[0], config.texture_ids[1]);
+        if (config.blend_params)
+        {
+            hash_combine(ret, config.blend_params->src_factor, config.blend_params->dst_factor,
+                         config.blend_params->src_alpha, config.blend_params->dst_alpha);
+        }
         return ret;
     }
 };
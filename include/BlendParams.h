@@ -16,6 +16,8 @@ struct BlendParams
     BlendParams() = default;
     BlendParams(BlendFactor src_fact, BlendFactor dst_fact);
     BlendParams(BlendFactor src_fact, BlendFactor dst_fact, BlendFactor src_a, BlendFactor dst_a);
+
+    bool operator==(const BlendParams &other) const = default;
 };
 
 //! \brief Calls OpenGL function which sets the blending function parameters
@@ -1,25 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <unordered_map>
 #include <memory>
 #include <string>
 #include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 #include <Rect.h>
 #include <Utils/Vector2.h>
 #include <FrameBuffer.h>
-
-//! \struct Character
-//! \brief holds Freetype character dimensions and relative position data
-struct Character
-{
-    unsigned int texture_id; // ID handle of the glyph texture
-    utils::Vector2i tex_coords;
-    utils::Vector2i size;    // Size of glyph
-    utils::Vector2i bearing; // Offset from baseline to left/top of glyph
-    Rectf bb;
-    unsigned int advance; // Offset to advance to next glyph
-};
+#include <GlyphCache.h>
+#include <GlyphTable.h>
 
 class Renderer;
 class FrameBuffer;
@@ -31,29 +25,84 @@ enum class FreetypeMode
     SDF = 5,
 };
 
+//! \brief what the font is created for
+enum class FontUsage
+{
+    Rendering,  //!< glyphs are rasterized into the GlyphCache, needs a GL context
+    MetricsOnly //!< only glyph metrics and kerning are loaded, works without GL and may be shared between threads
+};
+
 typedef struct FT_LibraryRec_ *FT_Library;
 typedef struct FT_FaceRec_ *FT_Face;
+struct hb_font_t;
+
+//! \struct ShapedGlyph
+//! \brief glyph positioned by the shaping stage, all distances are in pixels of the unscaled font
+struct ShapedGlyph
+{
+    int code;              //!< key of the glyph in the font (character code, or glyphIndexKey() of a shaped glyph)
+    std::size_t cluster;   //!< index of the first character of the text this glyph comes from
+    float x_advance = 0.f; //!< how far the pen moves after this glyph (kerning included)
+    float x_offset = 0.f;
+    float y_offset = 0.f;
+};
+
+//! \returns key under which a glyph given by its FreeType index (not by character code) is stored in a Font
+//!  shaping may produce glyphs which have no character code (ligatures, contextual forms ...)
+constexpr int glyphIndexKey(unsigned int glyph_index)
+{
+    return -static_cast<int>(glyph_index) - 1;
+}
+
+constexpr std::size_t FONT_SDF_MIN_RASTER_SIZE = 32; //! SDF glyphs are never rasterized smaller than this
+
+constexpr const char *BAKED_FONT_EXTENSION = ".font"; //! extension of the glyph table of a baked font
 
 //! \class Font
 //! \brief stores all data related to a given fotn
 //! \brief stores information necessary for drawing for each character in the font;
-//! \brief also contains texture, which contains all glyphs
+//! \brief the glyphs themselves live in the GlyphCache shared by all fonts
+//!  Glyphs are rasterized on first use by getCharacter() and packed into the atlas pages of the GlyphCache,
+//!  fonts with the same face, size and mode share them. Rasterized glyphs wait on the CPU
+//!  until uploadPendingGlyphs() sends all of them to the GPU at once (the Renderer does that when drawing text)
+//!  SDF glyphs are rasterized at the power of two size above the font size (at least FONT_SDF_MIN_RASTER_SIZE)
+//!  and their metrics are scaled down, so all SDF fonts of one face within an octave of sizes share the glyphs
+//!  A font can be baked by saveToFile() (see tools/FontBaker) into a binary glyph table and PNG atlas pages,
+//!  loading the baked font does not touch FreeType at all, but it has only the glyphs which were baked
+//!  Texts are positioned by shape(): FreeType kerning by default, HarfBuzz when built with USE_HARFBUZZ
+//!  A font created with FontUsage::MetricsOnly never touches GL, Text::getBoundingBox() and getTextWidth() work
+//!  with it on headless machines. Such font can be used by many threads at once (each measuring its own Text objects)
 class Font
 {
 public:
-    Font(std::filesystem::path font_filename, std::size_t font_pixel_size = 30, FreetypeMode mode = FreetypeMode::SDF);
-    Font(const unsigned char *bytes, std::size_t num_bytes, ::size_t font_pixel_size = 30, FreetypeMode mode = FreetypeMode::SDF);
+    Font(std::filesystem::path font_filename, std::size_t font_pixel_size = 30, FreetypeMode mode = FreetypeMode::SDF,
+         FontUsage usage = FontUsage::Rendering);
+    Font(const unsigned char *bytes, std::size_t num_bytes, ::size_t font_pixel_size = 30, FreetypeMode mode = FreetypeMode::SDF,
+         FontUsage usage = FontUsage::Rendering);
     Font(Texture &font_texture, std::unordered_map<int, Character> &char_map);
     ~Font();
 
     bool containsUTF8Code(unsigned int)const;
+    const Character &getCharacter(int code);
+    int getTexCode(int code);
+    void preload(const std::wstring &characters);
+    void uploadPendingGlyphs();
+    std::size_t getPagesCount() const;
+    Texture &getPage(std::size_t page_index);
+
     bool loadFromFile(std::filesystem::path font_filename);
     bool loadFromBytes(const unsigned char *bytes, std::size_t num_bytes);
     bool loadFromTexture(Texture &texture);
-    bool loadFromImage(const std::filesystem::path &image_path, const std::filesystem::path &metadata_path);
+    bool loadFromBaked(const std::filesystem::path &metadata_path);
     Texture &getTexture();
+    int getKerning(int left_code, int right_code);
+    std::vector<ShapedGlyph> shape(const std::wstring &text);
+    bool isBaked() const;
+    FontUsage getUsage() const;
+    std::size_t getGeneration() const;
 
     std::size_t getFontPixelSize() const;
+    std::size_t getRasterPixelSize() const;
     void setFontPixelSize(std::size_t font_pixe_size);
     FreetypeMode getMode() const;
 
@@ -61,29 +110,47 @@ public:
 
     GLuint getCharmapTexId() const;
 
-    void saveToFile(std::filesystem::path font_image, const std::string &font_name);
+    bool saveToFile(const std::filesystem::path &directory, const std::string &font_name);
 
 private:
-    void renderCharMapTexture();
     bool initializeFromFace(FT_Face &face);
+    void updateGlyphStyle();
+    Character &rasterizeGlyph(int code);
+    void rasterizeGlyphs(const std::vector<int> &codes);
+    GlyphBitmap rasterizeWithMainFace(int code);
+    Character loadGlyphMetrics(int code);
+    std::unique_lock<std::shared_mutex> lockMetrics() const;
+    bool openFace(FT_Library library, FT_Face &face) const;
 
 public:
-    std::unique_ptr<FrameBuffer> m_pixels;           //!< stores a framebuffer to draw all characters into (Do i need to store it?)
-    Texture *p_texture = nullptr;                    //!< stores a texture with all characters that we draw from when drawing text
-    std::unordered_map<int, Character> m_characters; //!< stores all Glyph data of respective characters
-    std::unordered_map<int, int> m_charcode2texcode;
+    GlyphTable m_characters; //!< stores Glyph data of already rasterized characters (scaled to the font size)
 
 private:
-    std::unique_ptr<FrameBuffer> m_prerendered;
-    std::unique_ptr<FrameBuffer> m_charmap_texture;
+    Character &packGlyph(int code, GlyphBitmap bitmap);
+    Character &registerCharacter(int code, const Character &cached_glyph);
 
     FreetypeMode m_mode = FreetypeMode::Normal;
     std::size_t m_font_pixel_size = 20;
+    std::size_t m_raster_pixel_size = 20; //!< size at which glyphs are rasterized
+    float m_glyph_scale = 1.f;            //!< font size / raster size
     float m_line_height;
 
-    std::unique_ptr<Renderer> m_canvas;
-    
-    GLuint m_charmap_tex_id = 0;
+    std::string m_source_name;      //!< identifies the face in glyph style names
+    std::uint32_t m_glyph_style = 0; //!< style of the font's glyphs in the GlyphCache
+
+    std::unordered_map<std::uint64_t, int> m_kerning; //!< kerning of baked fonts, keyed by (left << 32 | right) code
+    bool m_is_baked = false;                           //!< baked fonts have no FreeType face
+    FontUsage m_usage = FontUsage::Rendering;
+    mutable std::shared_mutex m_metrics_mutex; //!< guards glyphs and the FreeType face of metrics-only fonts
+    std::size_t m_generation = 0;                      //!< changes whenever already rasterized glyphs change
+
+    //! source of the font, worker threads open their own faces from it
+    std::filesystem::path m_font_file;
+    const unsigned char *mp_font_bytes = nullptr;
+    std::size_t m_font_bytes_count = 0;
+    std::vector<unsigned char> m_font_buffer; //!< file contents on Android
+
+    hb_font_t *mp_hb_font = nullptr; //!< HarfBuzz font, only used when built with USE_HARFBUZZ
 
     //! FT handles
     std::unique_ptr<FT_Face> mp_face;
@@ -26,6 +26,7 @@ public:
     FrameBuffer &operator=(FrameBuffer &&other) = default;
 
     void resize(int w, int h);
+    virtual void bind() override;
 
     Texture &getTexture();
     void setTexture(Texture &new_texture);
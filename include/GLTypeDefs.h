@@ -81,6 +81,15 @@ enum class TexWrapParam
 };
 GLint getGLCode(TexWrapParam p);
 
+//! \enum TextureTarget
+//! \brief kind of texture a handle refers to, which decides where it gets bound
+enum class TextureTarget
+{
+    Texture2D,     //!< ordinary 2D texture (Texture)
+    Texture2DArray //!< layered texture of same sized images (ArrayTexture)
+};
+GLenum getGLCode(TextureTarget target);
+
 enum class ShaderType
 {
     Vertex,
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "GLTypeDefs.h"
+#include "GlyphTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Texture;
+
+constexpr int FONT_ATLAS_PAGE_SIZE = 1024; //! width and height of one page of the glyph atlas
+constexpr int FONT_CHARMAP_WIDTH = 256;    //! number of glyphs in one row of the charmap texture
+
+//! \struct GlyphBitmap
+//! \brief glyph rendered by FreeType, not yet placed into the atlas
+struct GlyphBitmap
+{
+    bool loaded = false;
+    utils::Vector2i size = {0, 0};
+    utils::Vector2i bearing = {0, 0};
+    Rectf bb = {0, 0, 0, 0};
+    unsigned int advance = 0;
+    std::vector<unsigned char> pixels; //!< RGBA rows ordered bottom to top, as OpenGL wants them
+};
+
+//! \class GlyphCache
+//! \brief atlas pages and charmap texture shared by all fonts
+//!  Glyphs are keyed by a style (face, rasterized size and mode, see getStyleId()) and a code.
+//!  All glyphs index the same charmap texture, so texts of different fonts and sizes end up
+//!  in the same text batch whenever their glyphs are on the same page.
+//!  Rasterized glyphs wait on the CPU until uploadPendingGlyphs() sends all of them to the GPU at once.
+//!  Glyphs are never evicted, there is one cache for the whole GL context, accessible through instance()
+class GlyphCache
+{
+public:
+    static GlyphCache &instance();
+
+    GlyphCache(const GlyphCache &other) = delete;
+    GlyphCache &operator=(const GlyphCache &other) = delete;
+
+    std::uint32_t getStyleId(const std::string &style_name);
+    const Character *find(std::uint32_t style_id, int code) const;
+    const Character &insert(std::uint32_t style_id, int code, GlyphBitmap bitmap);
+
+    void uploadPendingGlyphs();
+    std::size_t getPagesCount() const;
+    Texture &getPage(std::size_t page_index);
+    std::size_t getPageIndex(GLuint page_handle) const;
+    GLuint getCharmapTexId() const;
+    std::size_t getGlyphsCount() const;
+
+private:
+    GlyphCache() = default;
+
+    void addPage();
+    void renderCharMapTexture();
+
+private:
+    //! \struct PendingGlyph
+    //! \brief rasterized glyph waiting for upload into its atlas page
+    struct PendingGlyph
+    {
+        std::size_t page_index;
+        utils::Vector2i tex_coords; //!< top-left corner in the page (y goes down)
+        utils::Vector2i size;
+        std::vector<unsigned char> pixels; //!< RGBA rows ordered bottom to top, as OpenGL wants them
+    };
+
+    std::unordered_map<std::string, std::uint32_t> m_style_ids;
+    std::unordered_map<std::uint64_t, Character> m_glyphs; //!< keyed by (style << 32 | code), records never move
+
+    std::vector<std::unique_ptr<Texture>> m_pages; //!< atlas pages, glyphs are packed into the last one
+    utils::Vector2i m_pen = {0, 0};                  //!< where the next glyph goes in the last page
+    int m_row_height = 0;                            //!< height of the tallest glyph in the current row
+    std::vector<PendingGlyph> m_pending_glyphs;
+    std::vector<Rectf> m_glyph_tex_rects;    //!< CPU copy of the charmap texture
+    int m_charmap_rows_count = 0;            //!< number of rows allocated in the charmap texture
+    std::size_t m_uploaded_glyphs_count = 0; //!< number of glyph rects already in the charmap texture
+    GLuint m_charmap_tex_id = 0;
+};
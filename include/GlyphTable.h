@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include <Rect.h>
+#include <Utils/Vector2.h>
+
+//! \struct Character
+//! \brief holds Freetype character dimensions and relative position data
+struct Character
+{
+    unsigned int texture_id; // ID handle of the glyph texture
+    utils::Vector2i tex_coords;
+    utils::Vector2i size;    // Size of glyph
+    utils::Vector2i bearing; // Offset from baseline to left/top of glyph
+    Rectf bb;
+    unsigned int advance; // Offset to advance to next glyph
+    int tex_code = -1;    // index of the glyph in the charmap texture (-1 means the record is empty)
+    utils::Vector2i tex_size = {0, 0}; // size of the glyph's rect in the atlas (differs from size when the glyph is scaled)
+};
+
+//! \class GlyphTable
+//! \brief maps character codes to their glyphs by direct indexing
+//!  Codes of the Basic Multilingual Plane are split into 256 pages of 256 glyphs, the first page (ASCII and Latin-1)
+//!  always exists, the others are allocated when their first glyph is inserted. Codes above the BMP go into a hash map.
+//!  Records never move once inserted, so references to them stay valid until clear()
+class GlyphTable
+{
+public:
+    GlyphTable();
+
+    const Character *find(int code) const;
+    Character *find(int code);
+    bool contains(int code) const;
+    Character &insert(int code, const Character &character);
+    void clear();
+    std::size_t size() const;
+
+    //! \brief calls \p function(code, character) for every stored glyph
+    template <class Function>
+    void forEach(Function function) const
+    {
+        for (std::size_t page_id = 0; page_id < m_pages.size(); ++page_id)
+        {
+            if (!m_pages[page_id])
+            {
+                continue;
+            }
+            for (std::size_t i = 0; i < PAGE_SIZE; ++i)
+            {
+                const auto &character = (*m_pages[page_id])[i];
+                if (character.tex_code >= 0)
+                {
+                    function(static_cast<int>(page_id * PAGE_SIZE + i), character);
+                }
+            }
+        }
+        for (auto &[code, character] : m_other_glyphs)
+        {
+            function(code, character);
+        }
+    }
+
+private:
+    static constexpr std::size_t PAGE_SIZE = 256;
+    static constexpr std::size_t PAGES_COUNT = 256;
+    using Page = std::array<Character, PAGE_SIZE>;
+
+    std::array<std::unique_ptr<Page>, PAGES_COUNT> m_pages;
+    std::unordered_map<int, Character> m_other_glyphs; //!< codes outside of the BMP (and negative ones)
+    std::size_t m_size = 0;
+};
+
+inline const Character *GlyphTable::find(int code) const
+{
+    if (static_cast<unsigned int>(code) < PAGE_SIZE * PAGES_COUNT)
+    {
+        const auto &page = m_pages[code / PAGE_SIZE];
+        if (!page)
+        {
+            return nullptr;
+        }
+        const auto &character = (*page)[code % PAGE_SIZE];
+        return character.tex_code >= 0 ? &character : nullptr;
+    }
+    auto it = m_other_glyphs.find(code);
+    return it == m_other_glyphs.end() ? nullptr : &it->second;
+}
+
+inline Character *GlyphTable::find(int code)
+{
+    return const_cast<Character *>(static_cast<const GlyphTable &>(*this).find(code));
+}
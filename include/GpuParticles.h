@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Shader.h"
+#include "Color.h"
+#include "Utils/Vector2.h"
+
+class Renderer;
+
+//! \class GpuParticles
+//! \brief emitter of particles that live only on the GPU
+//!  Particle state is kept in two vertex buffers. Each update runs a simulation vertex shader over one of them
+//!  (emission, aging, acceleration and drag are given by uniforms) and captures the result into the other using
+//!  transform feedback. Drawing reads the latest buffer directly, so particles are never copied to the CPU.
+//!  Particles are emitted into a ring of slots, when all of them are in use the oldest particles are replaced.
+class GpuParticles
+{
+
+public:
+    explicit GpuParticles(int n_max_particles = 10000);
+    ~GpuParticles();
+
+    GpuParticles(const GpuParticles &other) = delete;
+    GpuParticles &operator=(const GpuParticles &other) = delete;
+
+    void update(float dt);
+    void draw(Renderer &canvas);
+
+    void setSpawnPos(utils::Vector2f pos);
+    utils::Vector2f getSpawnPos() const;
+
+    void setInitColor(Color color);
+    void setFinalColor(Color color);
+
+    void setLifetime(float lifetime);
+
+    void setRepeat(bool repeats);
+    bool getRepeat() const;
+
+    void setPeriod(float period);
+    float getPeriod() const;
+
+    void setInitialSpeed(float min_speed, float max_speed);
+    void setAcceleration(utils::Vector2f acceleration);
+    void setDrag(float drag);
+    void setSize(float init_size, float final_size);
+
+    std::size_t capacity() const;
+
+public:
+    Color m_init_color = {1, 1, 1, 1};
+    Color m_final_color = {1, 1, 1, 0};
+    utils::Vector2f m_spawn_pos = {0, 0};
+
+private:
+    std::size_t countEmitted(float dt);
+
+private:
+    Shader m_simulation_shader;
+    Shader m_draw_shader;
+
+    GLuint m_state_buffers[2] = {0, 0};   //!< ping-pong buffers with the particle state
+    GLuint m_simulation_vaos[2] = {0, 0}; //!< m_simulation_vaos[i] reads m_state_buffers[i]
+    GLuint m_draw_vaos[2] = {0, 0};       //!< m_draw_vaos[i] draws quads for m_state_buffers[i]
+    GLuint m_quad_buffer = 0;
+    GLuint m_feedback = 0;
+    int m_current = 0; //!< index of the buffer with the latest state
+
+    std::size_t m_capacity = 0;
+    std::size_t m_next_slot = 0; //!< slot where the next particle is emitted
+    std::size_t m_spawned_count = 0;
+
+    float m_spawn_period = 0.03; //!< m_spawn_period secs need to pass for one particle
+    float m_spawn_timer = 0;     //!< time since the last spawn
+    bool m_repeats = true;       //!< true if particles should be created continuously
+    float m_time = 0;            //!< total simulated time, seeds the random numbers of the emission
+
+    float m_lifetime = 1.f;
+    utils::Vector2f m_speed_range = {50.f, 100.f};
+    utils::Vector2f m_acceleration = {0.f, 0.f};
+    float m_drag = 0.f; //!< velocity loses m_drag part of itself per second
+    utils::Vector2f m_size = {10.f, 10.f}; //!< size at birth and at the end of life
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Color.h"
+#include "Utils/Vector2.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+//! \struct Particle
+//! \brief contains data used in particle drawing + lifetime management
+struct Particle
+{
+    utils::Vector2f pos;
+    utils::Vector2f vel = {0, 0};
+    utils::Vector2f acc = {0, 0};
+    utils::Vector2f scale = {1, 1};
+    float angle = 0.f;
+    Color color = {0, 0, 0, 1};
+    float life_time = 1.f;
+    float time = 0;
+
+    Particle() = default;
+    Particle(utils::Vector2f init_pos, utils::Vector2f init_vel, utils::Vector2f acc = {0, 0}, utils::Vector2f scale = {1, 1},
+             Color color = {0, 0, 1, 1}, float life_time = 69);
+};
+
+//! \struct ParticleSpans
+//! \brief views into the arrays of particles, index i refers to the same particle in all of them
+struct ParticleSpans
+{
+    std::span<float> pos_x;
+    std::span<float> pos_y;
+    std::span<float> vel_x;
+    std::span<float> vel_y;
+    std::span<float> acc_x;
+    std::span<float> acc_y;
+    std::span<float> scale_x;
+    std::span<float> scale_y;
+    std::span<float> angle;
+    std::span<float> color_r;
+    std::span<float> color_g;
+    std::span<float> color_b;
+    std::span<float> color_a;
+    std::span<float> time;
+    std::span<float> life_time;
+
+    std::size_t size() const { return pos_x.size(); }
+    ParticleSpans subspan(std::size_t first, std::size_t count) const;
+};
+
+//! \class ParticleArrays
+//! \brief stores particles as a structure of arrays, each attribute is a separate contiguous array of floats
+//!  Kernels then stream through only the attributes they need and process several particles per instruction.
+//!  Live particles are always packed at the front, removal moves the last particle into the freed slot
+class ParticleArrays
+{
+public:
+    explicit ParticleArrays(std::size_t capacity = 0);
+
+    void setCapacity(std::size_t capacity);
+    std::size_t capacity() const;
+    std::size_t size() const;
+    void clear();
+
+    bool push(const Particle &particle);
+    Particle get(std::size_t index) const;
+    ParticleSpans spans();
+
+    std::size_t removeDead();
+
+private:
+    template <class Function>
+    void forEachArray(Function function);
+
+private:
+    std::vector<float> m_pos_x;
+    std::vector<float> m_pos_y;
+    std::vector<float> m_vel_x;
+    std::vector<float> m_vel_y;
+    std::vector<float> m_acc_x;
+    std::vector<float> m_acc_y;
+    std::vector<float> m_scale_x;
+    std::vector<float> m_scale_y;
+    std::vector<float> m_angle;
+    std::vector<float> m_color_r;
+    std::vector<float> m_color_g;
+    std::vector<float> m_color_b;
+    std::vector<float> m_color_a;
+    std::vector<float> m_time;
+    std::vector<float> m_life_time;
+
+    std::size_t m_size = 0; //!< number of live particles, arrays are allocated for the whole capacity
+};
+
+//! built-in kernels working on whole arrays, they use the widest SIMD instructions available (see utils::simd)
+namespace particle_kernels
+{
+    void integrateEuler(const ParticleSpans &particles, float dt);
+    void age(const ParticleSpans &particles, float dt);
+    void interpolateColors(const ParticleSpans &particles, Color init_color, Color final_color);
+    const char *getInstructionSet();
+} // namespace particle_kernels
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Particles.h"
+#include "ParticleSystem.h"
+#include "View.h"
+
+#include <functional>
+#include <vector>
+
+//! \class ParticleBudget
+//! \brief keeps the cost of particles within a budget by throttling spawning and drawing of registered emitters
+//!  Every frame (before the emitters update) it
+//!  1. culls emitters whose bounds are outside of the view: they neither spawn nor draw, but their particles still age
+//!  2. lowers the quality when the frame takes longer than the frame budget and raises it slowly when there is time,
+//!     the quality scales spawn rates and the drawn parts of the visible emitters
+//!  3. hands out the room left under the global cap of live particles, emitters with higher priority get it first
+//!  Emitters must stay alive while registered, remove them from the budget before destroying them
+class ParticleBudget
+{
+
+public:
+    explicit ParticleBudget(std::size_t max_particles = 100'000, float frame_budget_ms = 16.f);
+
+    void add(Particles &emitter, int priority = 0);
+    void add(ParticleSystem &emitter, int priority = 0);
+    void remove(const Particles &emitter);
+    void remove(const ParticleSystem &emitter);
+    void clear();
+
+    void update(const View &view, float frame_time_ms, float dt);
+
+    void setMaxParticles(std::size_t max_particles);
+    std::size_t getMaxParticles() const;
+    void setFrameBudget(float frame_budget_ms);
+    void setMinQuality(float min_quality);
+    void setCullMargin(float margin);
+
+    float getQuality() const;
+    std::size_t getLiveCount() const;
+    std::size_t getVisibleCount() const;
+
+private:
+    //! \struct Entry
+    //! \brief registered emitter, the functions hide whether it is Particles or ParticleSystem
+    struct Entry
+    {
+        const void *emitter;
+        int priority;
+        std::function<Rectf()> get_bounds;
+        std::function<std::size_t()> get_count;
+        std::function<float(float)> get_spawn_count; //!< expected number of spawned particles in a time step
+        std::function<void(float, float)> apply; //!< sets the spawn scale and the draw fraction
+    };
+
+    template <class EmitterT>
+    void addEmitter(EmitterT &emitter, int priority);
+    void updateQuality(float frame_time_ms);
+
+private:
+    std::vector<Entry> m_entries; //!< sorted by priority, highest first
+
+    std::size_t m_max_particles;
+    float m_frame_budget_ms;
+    float m_min_quality = 0.1f;
+    float m_cull_margin = 50.f; //!< bounds are enlarged by this in each direction before culling
+
+    float m_quality = 1.f;
+    float m_smoothed_frame_time_ms; //!< moving average, so that one slow frame does not change much
+    std::size_t m_live_count = 0;
+    std::size_t m_visible_count = 0;
+};
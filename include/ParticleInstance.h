@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Renderer.h"
+
+//! \struct ParticleInstance
+//! \brief the only data sent to the GPU per particle, the quad is made from it in the particle vertex shader
+//!  Registered in every Renderer, so particles are drawn using Renderer::drawInstances
+struct ParticleInstance : public Drawable<ParticleInstance>
+{
+    using VertexType = SpriteVertexLayout;
+    using InstanceType = ParticleInstance;
+
+    static BatchRegistry::BatchMaker makeBatchImpl()
+    {
+        VAOId layout;
+
+        layout.instanced_attributes = {
+            makeAttribute<utils::Vector2f>(), // pos
+            makeAttribute<utils::Vector2f>(), // scale
+            makeAttribute<float>(),           // angle
+            makeAttribute<Color>(),           // color
+        };
+
+        layout.vertex_attirbutes = SpriteVertexLayout::getVertexAttributes();
+        layout.vertices_size = SpriteVertexLayout::size;
+
+        layout.instance_size = sizeof(ParticleInstance);
+        layout.max_vertex_buffer_count = 6; //! vertices are just a square
+        layout.max_instance_count = 65536;  //! bigger batches are drawn in more draw calls
+
+        auto vertex_data = SpriteVertexLayout::getVertexData();
+        return [=]()
+        { return std::make_unique<InstancedBatch>(vertex_data, layout); };
+    }
+
+    utils::Vector2f pos = {0, 0};
+    utils::Vector2f scale = {1, 1}; //!< half of the width and height of the quad
+    float angle = 0.f;              //!< in degrees, as in Transform
+    Color color = {1, 1, 1, 1};     //!< floats, so that colors above 1 keep working with bloom
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ParticleArrays.h"
+#include "Rect.h"
+#include "Utils/SpatialGrid.h"
+
+#include <span>
+
+//! \brief interactions between particles (found with a SpatialGrid) and with the world
+//!  applyPairForces changes only velocities of the particles in [first, first + count) and reads only positions,
+//!  so disjoint ranges can run concurrently, as long as no positions change meanwhile
+namespace particle_interactions
+{
+    //! \struct PairForces
+    //! \brief forces between two particles, each falls linearly from its strength (an acceleration)
+    //! \brief for touching particles to zero at its radius
+    struct PairForces
+    {
+        float repulsion = 0.f;
+        float repulsion_radius = 0.f;
+        float attraction = 0.f;
+        float attraction_radius = 0.f;
+
+        float getRadius() const;
+    };
+
+    void applyPairForces(const ParticleSpans &particles, std::size_t first, std::size_t count,
+                         const utils::SpatialGrid &grid, const PairForces &forces, float dt);
+    void collideWithRects(const ParticleSpans &particles, std::span<const Rectf> colliders, float restitution);
+} // namespace particle_interactions
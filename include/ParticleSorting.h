@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ParticleInstance.h"
+#include "Utils/RadixSort.h"
+
+#include <optional>
+#include <vector>
+
+//! \enum ParticleOrder
+//! \brief order in which particles of one emitter are drawn, later particles are drawn over earlier ones
+enum class ParticleOrder
+{
+    None,    //!< storage order, which changes whenever a particle dies
+    ByAge,   //!< from the youngest to the oldest
+    ByDepth, //!< by the y coordinate, particles with larger y are drawn over those with smaller y
+};
+
+//! \enum ParticleBlending
+//! \brief how particles of one emitter are blended with what is already drawn
+enum class ParticleBlending
+{
+    Default,       //!< blending set in the Renderer (Renderer::m_blend_factors)
+    Alpha,         //!< straight alpha: src * a + dst * (1 - a)
+    Premultiplied, //!< colors premultiplied by alpha: src + dst * (1 - a)
+    Additive,      //!< src * a + dst, the result does not depend on the order, so it is never sorted
+};
+
+std::optional<BlendParams> getBlendParams(ParticleBlending blending);
+void thinOutInstances(std::vector<ParticleInstance> &instances, float fraction);
+std::size_t thinOutInstances(ParticleInstance *instances, std::size_t count, float fraction);
+
+//! \class ParticleSorter
+//! \brief puts instances of one emitter into their draw order (see ParticleOrder)
+//!  Uses a 16-bit radix sort, so the cost is linear in the number of particles
+class ParticleSorter
+{
+public:
+    void sort(std::vector<ParticleInstance> &instances, const float *ages, ParticleOrder order, ParticleBlending blending);
+    void sort(ParticleInstance *instances, std::size_t count, const float *ages, ParticleOrder order, ParticleBlending blending);
+
+private:
+    bool sortInto(const ParticleInstance *instances, std::size_t count, const float *ages, ParticleOrder order, ParticleBlending blending);
+
+private:
+    utils::RadixSorter m_sorter;
+    std::vector<float> m_keys;
+    std::vector<ParticleInstance> m_sorted; //!< kept between sorts so that its memory is reused
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ParticleArrays.h"
+#include "ParticleInstance.h"
+#include "ParticleInteractions.h"
+#include "ParticleSorting.h"
+#include "Utils/Rng.h"
+#include "Utils/SpatialGrid.h"
+
+#include <functional>
+#include <string>
+
+//! \class ParticleSystem
+//! \brief emitter of particles stored as a structure of arrays (see ParticleArrays)
+//!  Has the same controls as Particles, but the per-particle work is done by built-in SIMD kernels
+//!  (Euler integration, aging and color interpolation between m_init_color and m_final_color).
+//!  A custom updater gets views of whole arrays once per update instead of being called for every particle
+class ParticleSystem
+{
+public:
+    using Updater = std::function<void(const ParticleSpans &, float)>;
+    using Emitter = std::function<Particle(utils::Vector2f)>;
+    using SeededEmitter = std::function<Particle(utils::Vector2f, utils::Rng &)>;
+
+public:
+    explicit ParticleSystem(int n_max_particles = 1000);
+
+    void update(float dt);
+    void draw(Renderer &canvas);
+
+    void spawnParticles(float dt);
+    void buildGrid();
+    void interact(std::size_t first, std::size_t count, float dt);
+    void simulate(std::size_t first, std::size_t count, float dt);
+    void removeDeadParticles();
+    void fillInstances(ParticleInstance *instances, std::size_t first, std::size_t count);
+    void sortInstances(ParticleInstance *instances);
+
+    void setSpawnPos(utils::Vector2f pos);
+    utils::Vector2f getSpawnPos() const;
+
+    void setInitColor(Color color);
+    void setFinalColor(Color color);
+
+    void setLifetime(float lifetime);
+
+    void setRepeat(bool repeats);
+    bool getRepeat() const;
+
+    void setPeriod(float period);
+    float getPeriod() const;
+
+    void setUpdater(Updater new_updater);
+    void setEmitter(Emitter new_emitter);
+    void setEmitter(SeededEmitter new_emitter);
+    void setSeed(std::uint64_t seed);
+    utils::Rng &getRng();
+
+    void setEulerIntegration(bool integrates);
+    void setColorInterpolation(bool interpolates);
+
+    void setShader(const std::string &shader_id);
+
+    void setRepulsion(float strength, float radius);
+    void setAttraction(float strength, float radius);
+    void addCollider(Rectf collider);
+    void clearColliders();
+    void setRestitution(float restitution);
+    void setGridCellSize(float cell_size);
+    const utils::SpatialGrid &getGrid() const;
+
+    void setOrder(ParticleOrder order);
+    ParticleOrder getOrder() const;
+    void setBlending(ParticleBlending blending);
+    ParticleBlending getBlending() const;
+
+    void setSpawnScale(float scale);
+    void setDrawFraction(float fraction);
+    float getDrawFraction() const;
+    float getExpectedSpawnCount(float dt) const;
+    Rectf getBounds();
+
+    std::size_t size() const;
+    std::size_t capacity() const;
+    ParticleArrays &getParticles();
+
+public:
+    Color m_init_color = {1, 1, 1, 1};
+    Color m_final_color = {1, 1, 1, 0};
+    utils::Vector2f m_spawn_pos = {0, 0};
+
+private:
+    ParticleArrays m_particles;
+
+    Updater m_updater;
+    SeededEmitter m_emitter;
+    utils::Rng m_rng; //!< passed to the emitter, each emitter has its own, so emitters can spawn in parallel
+
+    float m_spawn_period = 0.03; //!< m_spawn_period secs need to pass for one particle
+    float m_spawn_timer = 0;     //!< time since the last spawn
+    float m_spawn_scale = 1.f;   //!< multiplies the spawn rate, set by ParticleBudget
+    float m_draw_fraction = 1.f; //!< part of the particles which is drawn, set by ParticleBudget
+    bool m_repeats = true;       //!< true if particles should be created continuously
+    std::size_t m_spawned_count = 0;
+
+    bool m_integrates = true;   //!< true if the built-in Euler integration moves the particles
+    bool m_interpolates = true; //!< true if colors go from m_init_color to m_final_color over the particle's life
+
+    float m_lifetime = 1.f; //!< life time of particles created by the default emitter
+    std::string m_shader_id = "ParticleDefault";
+
+    std::vector<ParticleInstance> m_instances; //!< kept between draws so that its memory is reused
+
+    utils::SpatialGrid m_grid;     //!< positions of the particles at the start of the update
+    float m_grid_cell_size = 0.f;  //!< if 0, the grid is built only for the pair forces
+    particle_interactions::PairForces m_pair_forces;
+    std::vector<Rectf> m_colliders;
+    float m_restitution = 0.5f;
+
+    ParticleOrder m_order = ParticleOrder::None;
+    ParticleBlending m_blending = ParticleBlending::Default;
+    ParticleSorter m_sorter;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ParticleSystem.h"
+#include "Utils/JobSystem.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! \class ParticleWorld
+//! \brief owns many ParticleSystem emitters and updates them in parallel using a JobSystem
+//!  Spawning (with building of the neighbour grid) and removal of dead particles run as one job per emitter,
+//!  interactions and the simulation are split into chunks
+//!  of at most m_chunk_size particles, so one huge emitter is spread over all threads as well.
+//!  Every chunk then writes its ParticleInstances into its own range of one shared array, so no locks are needed.
+//!  Ranges of emitters with the same blending lie next to each other and are pushed into one batch,
+//!  every emitter sorts its own range by its order (see ParticleSystem::setOrder and setBlending)
+//!  and thins it by its draw fraction, then the ranges are moved together.
+//!  Emitters and updaters of different emitters run concurrently, so they must not share mutable state.
+//!  With Emscripten everything runs on the calling thread (no threads without -pthread in the browser)
+class ParticleWorld
+{
+
+public:
+    explicit ParticleWorld(std::size_t n_threads = std::thread::hardware_concurrency());
+
+    ParticleSystem &addEmitter(int n_max_particles = 1000);
+    void removeEmitter(const ParticleSystem &emitter);
+    void clear();
+
+    std::size_t getEmittersCount() const;
+    ParticleSystem &getEmitter(std::size_t index);
+    std::size_t getParticlesCount() const;
+    std::size_t getThreadsCount() const;
+
+    void update(float dt);
+    void draw(Renderer &canvas);
+
+    void setChunkSize(std::size_t chunk_size);
+    void setShader(const std::string &shader_id);
+
+private:
+    struct Chunk
+    {
+        std::size_t emitter_index;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    //! \brief instances of all emitters with the same blending, drawn as one batch
+    struct BlendGroup
+    {
+        ParticleBlending blending;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    void makeChunks();
+    void compactInstances();
+
+private:
+    std::vector<std::unique_ptr<ParticleSystem>> m_emitters; //!< pointers, so that references to emitters stay valid
+    utils::JobSystem m_jobs;
+
+    std::vector<Chunk> m_chunks;
+    std::vector<std::size_t> m_instance_offsets;  //!< first instance of each emitter in m_instances
+    std::vector<std::size_t> m_drawn_counts;      //!< number of drawn instances of each emitter
+    std::vector<ParticleInstance> m_instances;    //!< drawn instances of all emitters from the last update
+    std::vector<std::size_t> m_draw_order;        //!< emitter indices ordered by their blending
+    std::vector<BlendGroup> m_blend_groups;       //!< ranges of m_instances with the same blending
+
+    std::size_t m_chunk_size = 4096;
+    std::string m_shader_id = "ParticleDefault"; //!< all emitters are drawn with this shader, one batch per blending
+};
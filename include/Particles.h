@@ -3,31 +3,16 @@
 #include "Vertex.h"
 #include "Vector2.h"
 #include "Texture.h"
+#include "ParticleArrays.h"
+#include "ParticleInstance.h"
+#include "ParticleSorting.h"
+#include "Rect.h"
 
 #include "Utils/ObjectPool.h"
+#include "Utils/Rng.h"
 
 #include <functional>
 
-//! \struct Particle
-//! \brief contains data used in particle drawing + lifetime management
-struct Particle
-{
-    utils::Vector2f pos;
-    utils::Vector2f vel = {0,0};
-    utils::Vector2f acc = {0,0};
-    utils::Vector2f scale = {1,1};
-    float angle = 0.f;
-    Color color = {0, 0, 0, 1};
-    float life_time = 1.f;
-    float time = 0;
-
-    Particle() = default;
-   virtual ~Particle() = default;
-
-    Particle(utils::Vector2f init_pos, utils::Vector2f init_vel, utils::Vector2f acc = {0, 0}, utils::Vector2f scale = {1, 1},
-             Color color = {0, 0, 1, 1}, float life_time = 69);
-};
-
 class Renderer;
 
 //! \class Particles
@@ -64,10 +49,25 @@ public:
     void setUpdater(std::function<void(Particle &, float dt)> new_updater);
     void setUpdaterFull(std::function<void(std::vector<Particle> &, int, float)> new_updater);
     void setEmitter(std::function<Particle(utils::Vector2f)> new_emitter);
+    void setEmitter(std::function<Particle(utils::Vector2f, utils::Rng &)> new_emitter);
     void setOnParticleDeathCallback(std::function<void(Particle &)> new_updater);
 
     void setShader(const std::string &shader_id);
 
+    void setOrder(ParticleOrder order);
+    ParticleOrder getOrder() const;
+    void setBlending(ParticleBlending blending);
+    ParticleBlending getBlending() const;
+
+    void setSeed(std::uint64_t seed);
+    utils::Rng &getRng();
+
+    void setSpawnScale(float scale);
+    void setDrawFraction(float fraction);
+    float getExpectedSpawnCount(float dt) const;
+    std::size_t size() const;
+    Rectf getBounds() const;
+
 public:
     Color m_init_color;
     Color m_final_color;
@@ -82,8 +82,9 @@ private:
 protected:
     std::function<void(Particle &, float)> m_updater = [](Particle &, float) {};
     std::function<void(Particle &)> m_on_particle_death = [](Particle &) {};
-    std::function<Particle(utils::Vector2f)> m_emitter = [](utils::Vector2f)
+    std::function<Particle(utils::Vector2f, utils::Rng &)> m_emitter = [](utils::Vector2f, utils::Rng &)
     { return Particle{}; };
+    utils::Rng m_rng; //!< passed to the emitter, owned by this emitter so that it can be seeded for replays
 
     utils::VectorMap<Particle> m_particle_pool;
 
@@ -94,12 +95,21 @@ protected:
     size_t n_spawned = 0;      //!< number of live particles
 
     float m_lifetime = 1.f; //!< maximum time of life of the particle in seconds (when particle lives this long, it gets killed)
-    std::string m_shader_id = "VertexArrayDefault"; //!< shader id
+    std::string m_shader_id = "ParticleDefault"; //!< shader id
+
+    std::vector<ParticleInstance> m_instances; //!< kept between draws so that its memory is reused
+    std::vector<float> m_ages;                 //!< ages of the particles of m_instances, used for sorting
+
+    float m_spawn_scale = 1.f;   //!< multiplies the spawn rate, set by ParticleBudget
+    float m_draw_fraction = 1.f; //!< part of the particles which is drawn, set by ParticleBudget
+
+    ParticleOrder m_order = ParticleOrder::ByAge;
+    ParticleBlending m_blending = ParticleBlending::Default;
+    ParticleSorter m_sorter;
 };
 
 //! \class TexturedParticles
-//! \brief probably not working at the moment :(
-//! \todo will fix when necessary
+//! \brief particles drawn with a texture stretched over each of them
 class TexturedParticles : public Particles
 {
 
@@ -15,8 +15,10 @@ protected:
     RenderTarget() = default;
 
 public:
+    virtual ~RenderTarget() = default;
+
     utils::Vector2i getSize()const;
-    void bind();
+    virtual void bind();
     float getAspect()const;
 
     //! \brief does not necessarily clear the currently bound RenderTarget!!! DO NOT FORGET!!!
@@ -43,6 +43,13 @@ public:
     template <class DrawableT>
     void drawBatched(DrawableT &drawable, const std::string &shader_id, TextureArray textures = {0, 0});
 
+    template <class InstanceT>
+    void drawInstances(const std::vector<InstanceT> &instances, const std::string &shader_id, TextureArray textures = {0, 0},
+                       std::optional<BlendParams> blend_params = std::nullopt);
+    template <class InstanceT>
+    void drawInstances(const InstanceT *instances, std::size_t count, const std::string &shader_id, TextureArray textures = {0, 0},
+                       std::optional<BlendParams> blend_params = std::nullopt);
+
     template <class DrawableT>
     void registerDrawable();
 
@@ -69,7 +76,7 @@ public:
 
 private:
     void drawSpriteUnpacked(Vec2 center, Vec2 scale, float angle, ColorByte color, Rect<int> tex_rect, Vec2 texture_size,
-                            TextureArray &textures, const std::string &shader_id);
+                            TextureArray &textures, TextureTarget texture_target, int texture_layer, const std::string &shader_id);
 
     bool checkShader(const std::string &shader_id);
 
@@ -103,6 +110,32 @@ void Renderer::drawBatched(DrawableT &drawable, const std::string &shader_id, Te
     m_batches.pushInstance(drawable.getInstance(), config);
 }
 
+//! \brief copies all \p instances into one batch at once
+//! \param instances       the type must be registered first (see registerDrawable)
+//! \param shader_id       shader taking the attributes of InstanceT
+//! \param textures        textures bound when drawing the batch
+//! \param blend_params    blending of the batch, instances with different blending go into different batches
+template <class InstanceT>
+void Renderer::drawInstances(const std::vector<InstanceT> &instances, const std::string &shader_id, TextureArray textures,
+                             std::optional<BlendParams> blend_params)
+{
+    drawInstances(instances.data(), instances.size(), shader_id, textures, blend_params);
+}
+
+//! \brief copies \p count instances starting at \p instances into one batch at once (see above)
+template <class InstanceT>
+void Renderer::drawInstances(const InstanceT *instances, std::size_t count, const std::string &shader_id, TextureArray textures,
+                             std::optional<BlendParams> blend_params)
+{
+    if (count == 0 || !checkShader(shader_id))
+    {
+        return;
+    }
+    BatchConfig config(textures, &m_shaders.get(shader_id));
+    config.blend_params = blend_params;
+    m_batches.pushInstances(instances, count, config);
+}
+
 template <class DrawableT>
 void Renderer::registerDrawable()
 {
@@ -88,6 +88,8 @@ public:
     void setReloadOnChange(bool new_flag_value);
     bool getReloadOnChange() const;
 
+    void setTransformFeedbackVaryings(std::vector<std::string> varyings);
+
     friend ShaderHolder;
 
 private:
@@ -109,6 +111,8 @@ private:
 
     VariablesData m_variables; //!< contains data about uniforms and textures in the fragment shader.
 
+    std::vector<std::string> m_feedback_varyings; //!< vertex shader outputs captured by transform feedback
+
 public:
     inline static float m_time;
 };
@@ -4,6 +4,7 @@
 #include <filesystem>
 
 class Shader;
+class AssetPack;
 
 
 //! \class ShaderHolder
@@ -22,6 +23,7 @@ public:
 
     bool load(const std::string &name, const std::string &vertex_filename, const std::string &fragment_filename);
     bool loadFromCode(const std::string &id, const std::string &vertex_code, const std::string &fragment_code);
+    bool loadFromPack(const std::string &id, const AssetPack &pack, const std::string &vertex_entry, const std::string &fragment_entry);
 
     void erase(const std::string &shader_id);
 
@@ -8,6 +8,7 @@
 #include "Color.h"
 
 class Texture;
+class ArrayTexture;
 
 //! \struct RectangleSimple
 //! \brief a transform with width and height, which represents a rectangle
@@ -30,9 +31,12 @@ struct Sprite : public Transform
     void setTexture(const Texture &texture);
     void setTexture(GLuint id, int slot = 0);
     void setTexture(int slot, const Texture &texture);
+    void setTexture(const ArrayTexture &texture, int layer);
 
     ColorByte m_color = {255, 255, 255, 255};
     TextureArray m_texture_handles = {}; //!< GL handles of the bound textures
+    TextureTarget m_texture_target = TextureTarget::Texture2D; //!< Texture2DArray when the handles belong to ArrayTextures
+    int m_texture_layer = 0;                                     //!< layer of the ArrayTexture that is drawn
     utils::Vector2i m_tex_size = {1, 1};        //!< ???
     Rect<int> m_tex_rect = {0,0,1,1};          //!< defines part of the texture that will be drawn
 };
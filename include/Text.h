@@ -3,6 +3,21 @@
 #include "Transform.h"
 #include "Font.h"
 #include "Rect.h"
+#include "VertexArrayObject.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! \struct GlyphRun
+//! \brief laid out glyphs of a Text, ready to be copied into text batches
+struct GlyphRun
+{
+    std::vector<std::pair<GLuint, std::vector<TextInstance>>> pages; //!< (atlas page, glyphs drawn from it)
+    std::vector<ShapedGlyph> shaped_glyphs;                           //!< output of the shaping, in visual order
+    Rect<float> bounding_box = {0, 0, 0, 0};
+    float depth_under_line = 0.f;
+};
 
 //! \class Text
 //! \brief contains necessary data to draw texts
@@ -13,13 +28,13 @@ class Text : public Transform
 {
 
 public:
-    explicit Text(std::string text = "");
+    explicit Text(std::string_view text = "");
 
     void setFont(Font *font);
     Font *getFont() const;
 
-    void setText(const std::string &new_text);
-    std::string getText() const;
+    void setText(std::string_view new_text);
+    const std::string &getText() const;
     const std::wstring &getTextW() const;
     
     void setColor(ColorByte new_color);
@@ -28,6 +43,7 @@ public:
     Rect<float> getBoundingBox() const;
     float getDepthUnderLine() const;
     float getTextWidth() const;
+    const GlyphRun &getGlyphRun() const;
 
     float getCursorPosition(std::size_t cursor_pos);
     std::size_t getCursor(float pos);
@@ -44,11 +60,44 @@ public:
     ColorByte m_glow_color = {0, 0, 0, 0};
     ColorByte m_color = {255, 255, 255, 255};
 
+private:
+    void updateGlyphRun() const;
+    void translateGlyphRun(utils::Vector2f delta) const;
+
 private:
     Font *m_font = nullptr;
-    std::wstring m_text = L"";
+    std::string m_text_utf8 = "";
+    std::wstring m_text = L""; //!< decoded m_text_utf8
+
+    //! layout is cached and recomputed only when something it depends on changes
+    mutable GlyphRun m_glyph_run;
+    mutable bool m_glyph_run_valid = false; //!< false after text or font changed
+    mutable std::size_t m_run_font_generation = 0;
+    mutable utils::Vector2f m_run_position = {0, 0};
+    mutable utils::Vector2f m_run_scale = {1, 1};
+    mutable ColorByte m_run_colors[3]; //!< fill, edge and glow color
 };
 
+//! \brief horizontal alignment of lines in a MultiLineText
+enum class TextAlign
+{
+    Left,
+    Center,
+    Right
+};
+
+//! \brief how MultiLineText chooses where lines end
+enum class LineBreaking
+{
+    Greedy,  //!< puts as many words on a line as fit
+    Balanced //!< minimizes the raggedness of the paragraph (sum of squared free space of all but the last line)
+};
+
+//! \class MultiLineText
+//! \brief text wrapped into a page of given width
+//!  The text is split into paragraphs by '\n'. Each paragraph keeps its words (shaped Text objects)
+//!  and its line breaks, so they are computed only after the paragraph itself or the layout settings change.
+//!  Drawing positions the words of visible lines only, moved words just translate their cached glyphs.
 class MultiLineText
 {
 public:
@@ -57,34 +106,69 @@ public:
     void drawInto(Renderer &canvas);
     void drawInto2(Renderer &canvas);
 
-    void setText(std::string text);
+    void setText(std::string_view text);
+    std::string getText() const;
+    void appendText(std::string_view text);
+    void setParagraph(std::size_t index, std::string_view text);
+    std::size_t getParagraphsCount() const;
+    std::size_t getLinesCount();
 
     utils::Vector2f getPosition() const;
     void setPosition(utils::Vector2f position);
 
     void setPageWidth(float width);
     float getPageWidth() const;
-    float getPageHeight() const;
+    float getPageHeight();
     void setPadding(utils::Vector2f padding);
     void setWordSpacing(float spacing);
     void setLineSpacing(float spacing);
     void setScale(float scale);
     void setFont(Font *font);
+    void setAlignment(TextAlign alignment);
+    void setLineBreaking(LineBreaking line_breaking);
+    void setClipRect(Rect<float> clip_rect);
+    void disableClipping();
     float leftTextBorder() const;
     float rightTextBorder() const;
 
+    void updateLayout();
+
+private:
+    struct Paragraph
+    {
+        std::string text;
+        std::vector<Text> words;
+        std::vector<float> word_widths;
+        std::vector<std::size_t> line_starts; //!< index of the first word of every line
+        std::vector<float> line_widths;
+        bool words_valid = false;  //!< false after the text, font or scale changed
+        bool breaks_valid = false; //!< false after the words or the page width changed
+    };
+
+    void updateWords(Paragraph &paragraph);
+    void breakLines(Paragraph &paragraph) const;
+    void invalidateWords();
+    void invalidateBreaks();
+    template <class DrawFunction>
+    void drawLines(Renderer &canvas, DrawFunction draw_word);
+
 private:
-    std::string m_text;
+    std::vector<Paragraph> m_paragraphs = {Paragraph{}};
 
     Font *p_font = nullptr;
+    std::size_t m_layout_font_generation = 0;
 
     utils::Vector2f m_page_padding = {0.f, 0.f};
     utils::Vector2f m_page_position = {0.f, 0.f};
     float m_line_size = 30; //! should be calculated from font probably
     float m_page_width = 600;
-    float m_page_height; //! is calculated from text
+    float m_page_height = 0; //! is calculated from text
     float m_line_spacing = 2;
     float m_word_spacing = 10;
+    float m_space_width = 0; //! advance of the space glyph
     float m_text_scale = 1.;
-    bool m_split_words = false;
+    TextAlign m_alignment = TextAlign::Left;
+    LineBreaking m_line_breaking = LineBreaking::Greedy;
+    Rect<float> m_clip_rect = {0, 0, 0, 0};
+    bool m_clip_to_rect = false; //! when false, lines outside of the canvas view are skipped
 };
@@ -3,10 +3,24 @@
 #include "GLTypeDefs.h"
 #include "Vertex.h"
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
+
+class AssetPack;
+
+//! \enum MipmapGeneration
+//! \brief decides when mipmap levels of a texture are computed
+enum class MipmapGeneration
+{
+    None,    //!< only the base level exists, mipmap filters sample the base level
+    Eager,   //!< mipmaps are generated whenever the base level is uploaded
+    Lazy,    //!< mipmaps are generated only when the texture gets drawn minified after its base level changed
+    Streamed //!< images upload the coarsest level first and the finer levels over the next frames (see TextureHolder::streamMipmaps)
+};
 
 //! \struct TextureOptions
 //! \brief aggregates different OpenGL texture configurations
@@ -22,6 +36,7 @@ struct TextureOptions
     TexWrapParam wrap_x = TexWrapParam::ClampEdge;
     TexWrapParam wrap_y = TexWrapParam::ClampEdge;
     int mipmap_levels = 4;
+    MipmapGeneration mipmap_generation = MipmapGeneration::Eager;
 };
 
 //! \class Texture
@@ -62,10 +77,22 @@ public:
     TextureHandle getHandle() const;
 
     const TextureOptions &getOptions() const;
+    std::size_t getByteSize() const;
+
+    void releaseStorage();
+
+    void generateMipmaps();
+    void markMipmapsDirty();
+
+    bool isStreaming() const;
+    bool streamNextLevel();
 
 private:
     void invalidate();
     void initialize(TextureOptions options);
+    void uploadImage(const unsigned char *data, int channels_count, TextureOptions options);
+    void allocateMipmapLevels(GLint internal_format, GLenum format, GLenum data_type);
+    int getMipmapLevelsCount() const;
 
 private:
     GLuint m_texture_handle = 0; //! OpenGL id for texture
@@ -73,18 +100,38 @@ private:
 
     int m_width = 0;
     int m_height = 0;
+
+    //! CPU copies of levels that still wait for upload in the Streamed mode (finest first)
+    std::vector<std::vector<unsigned char>> m_pending_levels;
+    int m_streamed_level = 0; //!< finest level that is already on the GPU
+    int m_channels_count = 4;
 };
 
+void requestMipmaps(GLuint texture_handle);
+
 //! \class TextureHolder
 //! \brief holds textures based on id given by string
+//!  Textures loaded from files, buffers or asset packs are deduplicated by a hash of their encoded bytes and options,
+//!  so the same image added under different names shares one Texture. The Texture is released once all its names are erased
 class TextureHolder
 {
 
+public:
+    //! \struct CacheStats
+    //! \brief how much GPU memory was saved by sharing textures with the same content
+    struct CacheStats
+    {
+        std::size_t names_count = 0;    //!< number of stored names
+        std::size_t textures_count = 0; //!< number of distinct textures
+        std::size_t bytes_saved = 0;    //!< bytes that the duplicate textures would occupy
+    };
+
 public:
     bool add(std::string texture_name, Texture &texture);
     bool add(std::string texture_name, std::string filename, TextureOptions opt = {});
     bool add(std::string texture_name, std::filesystem::path texture_file_path, TextureOptions opt = {});
     bool add(std::string texture_name, const unsigned char *buffer, std::size_t size, TextureOptions opt = {});
+    bool add(std::string texture_name, const AssetPack &pack, const std::string &entry_name, TextureOptions opt = {});
 
     void erase(const std::string &texture_id);
 
@@ -93,7 +140,21 @@ public:
 
     bool setBaseDirectory(std::filesystem::path directory);
 
+    std::size_t streamMipmaps(std::size_t max_uploads_count = 1);
+
+    CacheStats getCacheStats() const;
+
 private:
+    std::shared_ptr<Texture> findOrLoad(const unsigned char *buffer, std::size_t size, const TextureOptions &opt, bool &is_new);
+
+private:
+    struct CachedContent
+    {
+        std::weak_ptr<Texture> texture;
+        std::size_t size = 0; //!< size of the encoded bytes (guards against hash collisions)
+    };
+
     std::unordered_map<std::string, std::shared_ptr<Texture>> m_textures;
+    std::unordered_map<std::uint64_t, CachedContent> m_content_cache; //!< keyed by hash of encoded bytes and options
     std::filesystem::path m_resources_path;
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "GLTypeDefs.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+class Texture;
+
+//! \class TextureResidency
+//! \brief keeps the GPU memory used by textures under a configurable budget
+//!  Textures are registered together with a function which can load them again from their source (file, asset pack ...).
+//!  Batches report which textures they actually flushed, so every texture knows the last frame it was drawn in.
+//!  When the resident textures exceed the budget, the least recently used ones get their GPU storage released.
+//!  The GL handle of an evicted texture stays valid, so sprites holding it do not notice anything:
+//!  the texture is reloaded from its source the next time a batch uses it (or it is fetched from a TextureHolder)
+//!  There is one residency for the whole GL context, accessible through instance()
+class TextureResidency
+{
+public:
+    using ReloadFunction = std::function<void(Texture &)>;
+
+    struct Stats
+    {
+        std::size_t resident_bytes = 0;
+        std::size_t tracked_count = 0;
+        std::size_t resident_count = 0;
+        std::size_t eviction_count = 0; //!< total number of evictions since start
+        std::size_t reload_count = 0;   //!< total number of reloads since start
+    };
+
+public:
+    static TextureResidency &instance();
+
+    void setBudget(std::size_t budget_bytes);
+    std::size_t getBudget() const;
+
+    void track(const std::shared_ptr<Texture> &texture, ReloadFunction reload);
+    void untrack(GLuint texture_handle);
+    bool isTracked(GLuint texture_handle) const;
+
+    void markUsed(GLuint texture_handle);
+    void markUsed(const TextureArray &texture_handles);
+
+    void endFrame();
+    std::size_t getFrame() const;
+
+    std::size_t evictUnused(std::size_t bytes_to_free);
+    Stats getStats() const;
+
+private:
+    TextureResidency() = default;
+
+    void enforceBudget();
+
+private:
+    struct Record
+    {
+        std::weak_ptr<Texture> texture;
+        ReloadFunction reload;
+        std::size_t byte_size = 0;
+        std::size_t last_used_frame = 0;
+        bool resident = true;
+    };
+
+    std::unordered_map<GLuint, Record> m_records; //!< keyed by OpenGL texture handle
+
+    std::size_t m_budget = 0; //!< 0 means unlimited
+    std::size_t m_frame = 0;
+    std::size_t m_resident_bytes = 0;
+    std::size_t m_eviction_count = 0;
+    std::size_t m_reload_count = 0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+
+    //! \class JobSystem
+    //! \brief runs many small jobs on a fixed set of worker threads
+    //!  Every thread (the caller of parallelFor included) has its own queue of jobs. A thread takes jobs from the back
+    //!  of its queue and when it runs out, it steals from the front of the queues of the others,
+    //!  so uneven jobs (one big emitter next to many small ones) still keep all threads busy.
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void(std::size_t)>;
+
+    public:
+        explicit JobSystem(std::size_t n_threads = std::thread::hardware_concurrency());
+        ~JobSystem();
+
+        JobSystem(const JobSystem &other) = delete;
+        JobSystem &operator=(const JobSystem &other) = delete;
+
+        void parallelFor(std::size_t jobs_count, const Job &job);
+
+        std::size_t getThreadsCount() const;
+
+    private:
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<std::size_t> job_indices;
+        };
+
+        bool runOneJob(std::size_t thread_index);
+        void workerLoop(std::size_t thread_index);
+
+    private:
+        std::vector<std::unique_ptr<JobQueue>> m_queues; //!< queue 0 belongs to the thread calling parallelFor
+        std::vector<std::thread> m_workers;
+
+        const Job *m_job = nullptr;               //!< job of the running parallelFor
+        std::atomic<std::size_t> m_remaining = 0; //!< jobs of the running parallelFor that did not finish yet
+
+        std::mutex m_wake_mutex;
+        std::condition_variable m_wake;
+        std::size_t m_generation = 0; //!< increases with each parallelFor, wakes the workers
+        bool m_stopping = false;
+    };
+
+} // namespace utils
@@ -1,12 +1,23 @@
 
 #pragma once
 
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
 #include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace utils
 {
 
+    //! \class VectorMap
+    //! \brief densely packed data addressed by stable entity indices, the data are one std::vector
+    //!  For handles which detect stale access and storage which grows without moving the data, see BasicPool
     template <typename Type>
     class VectorMap
     {
@@ -17,12 +28,14 @@ namespace utils
 
         void removeByDataInd(int data_ind);
         void removeByEntityInd(int entity_ind);
+        template <class Predicate>
+        std::size_t removeIf(Predicate &&predicate, bool keep_order = false);
 
         size_t insert(auto &&datum);
 
         void clear();
-        size_t size();
-        size_t capacity();
+        size_t size() const;
+        size_t capacity() const;
         void setMaxCount(int n_max_count);
 
 
@@ -30,6 +43,7 @@ namespace utils
         size_t getEntityInd(int data_ind) const;
 
         std::vector<Type> &getData();
+        const std::vector<Type> &getData() const;
 
     private:
         size_t n_max_entities = 0;
@@ -42,7 +56,7 @@ namespace utils
     };
 
     template <class T>
-    size_t VectorMap<T>::capacity()
+    size_t VectorMap<T>::capacity() const
     {
         return n_max_entities;
     }
@@ -53,6 +67,12 @@ namespace utils
         return m_data;
     }
 
+    template <class T>
+    const std::vector<T> &VectorMap<T>::getData() const
+    {
+        return m_data;
+    }
+
     template <class T>
     size_t VectorMap<T>::getEntityInd(int data_ind) const
     {
@@ -68,10 +88,18 @@ namespace utils
         m_data.reserve(n_max_entities);
     }
 
+    //! \brief changes the maximum number of entities, the index maps grow with it
+    //! \brief the maximum never gets below the number of live entities
     template <class T>
     void VectorMap<T>::setMaxCount(int n_max_count)
     {
-        n_max_entities = n_max_count;
+        n_max_entities = std::max<std::size_t>(n_max_count, n_active);
+        if (m_entity2data_ind.size() < n_max_entities)
+        {
+            m_entity2data_ind.resize(n_max_entities, -1);
+            m_data2entity_ind.resize(n_max_entities, -1);
+        }
+        m_data.reserve(n_max_entities);
     }
 
     template <class T>
@@ -115,6 +143,77 @@ namespace utils
         n_active--;
     }
 
+    //! \brief removes all data for which \p predicate returns true in a single pass
+    //! \brief entity indices of the remaining data stay valid, the removed ones go into the freelist
+    //! \param predicate   called once for each datum
+    //! \param keep_order  if true the remaining data keep their order, otherwise the removed ones
+    //!                     are replaced by the last ones (fewer moves)
+    //! \returns number of removed data
+    template <class T>
+    template <class Predicate>
+    std::size_t VectorMap<T>::removeIf(Predicate &&predicate, bool keep_order)
+    {
+        auto free_entity = [this](int entity_ind)
+        {
+            m_entity2data_ind[entity_ind] = m_freelist_head;
+            m_freelist_head = entity_ind;
+        };
+        auto move_datum = [this](std::size_t from, std::size_t to)
+        {
+            m_data[to] = std::move(m_data[from]);
+            auto entity_ind = m_data2entity_ind[from];
+            m_data2entity_ind[to] = entity_ind;
+            m_entity2data_ind[entity_ind] = to;
+        };
+
+        const std::size_t old_active = n_active;
+        if (keep_order)
+        {
+            std::size_t write_ind = 0;
+            for (std::size_t read_ind = 0; read_ind < old_active; ++read_ind)
+            {
+                if (predicate(m_data[read_ind]))
+                {
+                    free_entity(m_data2entity_ind[read_ind]);
+                    continue;
+                }
+                if (write_ind != read_ind)
+                {
+                    move_datum(read_ind, write_ind);
+                }
+                write_ind++;
+            }
+            n_active = write_ind;
+        }
+        else
+        {
+            std::size_t data_ind = 0;
+            while (data_ind < n_active)
+            {
+                if (!predicate(m_data[data_ind]))
+                {
+                    data_ind++;
+                    continue;
+                }
+                free_entity(m_data2entity_ind[data_ind]);
+                auto last_ind = n_active - 1;
+                if (data_ind != last_ind) //! the moved datum is tested in the next iteration
+                {
+                    move_datum(last_ind, data_ind);
+                }
+                n_active--;
+            }
+        }
+
+        for (std::size_t data_ind = n_active; data_ind < old_active; ++data_ind)
+        {
+            m_data2entity_ind[data_ind] = -1;
+        }
+        m_data.erase(m_data.begin() + n_active, m_data.end());
+        return old_active - n_active;
+    }
+
+    //! \returns entity index of the inserted \p datum or -1 when the map already holds the maximum count
     template <class T>
     size_t VectorMap<T>::insert(auto &&datum)
     {
@@ -139,7 +238,7 @@ namespace utils
     }
 
     template <class T>
-    size_t VectorMap<T>::size()
+    size_t VectorMap<T>::size() const
     {
         return n_active;
     }
@@ -153,12 +252,344 @@ namespace utils
     template <class T>
     void VectorMap<T>::clear()
     {
-        for (size_t i = 0; i < n_max_entities; ++i)
+        for (size_t i = 0; i < m_entity2data_ind.size(); ++i)
         {
             m_entity2data_ind[i] = -1;
             m_data2entity_ind[i] = -1;
         }
+        m_data.clear();
+        m_freelist_head = -1;
         n_active = 0;
     }
 
-}
\ No newline at end of file
+
+    //! \struct PoolHandle
+    //! \brief refers to an object in a BasicPool
+    //!  The slot index is reused by later objects, the generation tells them apart, so a handle of a removed
+    //!  object never reaches its successor
+    struct PoolHandle
+    {
+        static constexpr std::uint32_t INVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = INVALID_INDEX;
+        std::uint32_t generation = 0;
+
+        bool isValid() const { return index != INVALID_INDEX; }
+        bool operator==(const PoolHandle &other) const = default;
+    };
+
+    //! \class BasicPool
+    //! \brief pool of objects addressed by generational handles, each object is a row of \p Columns
+    //!  Live objects are densely packed, so iteration touches only live data. Each column is stored separately
+    //!  (structure of arrays) in chunks of \p ChunkSize objects, so growing the pool never moves existing objects.
+    //!  Removal moves the last object into the freed place, use handles (not pointers) to keep track of objects.
+    //!  ObjectPool<T> is a pool with a single column, ColumnPool<Columns...> one with many
+    template <std::size_t ChunkSize, class... Columns>
+    class BasicPool
+    {
+        static_assert(ChunkSize > 0, "Chunks must hold at least one object!");
+        static_assert(sizeof...(Columns) > 0, "Pool needs at least one column!");
+
+        template <std::size_t Column>
+        using ColumnType = std::tuple_element_t<Column, std::tuple<Columns...>>;
+
+    public:
+        static constexpr std::size_t CHUNK_SIZE = ChunkSize;
+        static constexpr std::size_t NO_LIMIT = std::numeric_limits<std::uint32_t>::max();
+
+    public:
+        BasicPool() = default;
+        explicit BasicPool(std::size_t max_count);
+
+        PoolHandle insert(Columns... values);
+        bool remove(PoolHandle handle);
+        template <class Predicate>
+        std::size_t removeIf(Predicate &&predicate);
+        void clear();
+
+        bool contains(PoolHandle handle) const;
+        template <std::size_t Column = 0>
+        ColumnType<Column> *get(PoolHandle handle);
+        template <std::size_t Column = 0>
+        ColumnType<Column> &at(std::size_t dense_index);
+        PoolHandle getHandle(std::size_t dense_index) const;
+
+        template <class Function>
+        void forEach(Function &&function);
+        template <class Function>
+        void forEachChunk(Function &&function);
+
+        std::size_t size() const;
+        std::size_t capacity() const;
+        void reserve(std::size_t count);
+        void setMaxCount(std::size_t max_count);
+        std::size_t getMaxCount() const;
+
+    private:
+        struct Chunk
+        {
+            std::tuple<std::array<Columns, ChunkSize>...> columns;
+        };
+
+        //! \struct Slot
+        //! \brief where the object of a handle lives, free slots make a linked list through dense_index
+        struct Slot
+        {
+            std::uint32_t dense_index = PoolHandle::INVALID_INDEX;
+            std::uint32_t generation = 0;
+        };
+
+        template <std::size_t Column>
+        ColumnType<Column> &element(std::size_t dense_index);
+        void removeDense(std::size_t dense_index);
+
+    private:
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        std::vector<Slot> m_slots;
+        std::vector<std::uint32_t> m_dense2slot; //!< slot of each live object
+        std::uint32_t m_freelist_head = PoolHandle::INVALID_INDEX;
+        std::size_t m_size = 0;
+        std::size_t m_max_count = NO_LIMIT;
+    };
+
+    template <class T, std::size_t ChunkSize = 1024>
+    using ObjectPool = BasicPool<ChunkSize, T>;
+
+    template <class... Columns>
+    using ColumnPool = BasicPool<1024, Columns...>;
+
+    //! \param max_count    inserting more objects fails (see setMaxCount)
+    template <std::size_t ChunkSize, class... Columns>
+    BasicPool<ChunkSize, Columns...>::BasicPool(std::size_t max_count)
+    {
+        setMaxCount(max_count);
+    }
+
+    template <std::size_t ChunkSize, class... Columns>
+    template <std::size_t Column>
+    typename BasicPool<ChunkSize, Columns...>::template ColumnType<Column> &BasicPool<ChunkSize, Columns...>::element(std::size_t dense_index)
+    {
+        return std::get<Column>(m_chunks[dense_index / ChunkSize]->columns)[dense_index % ChunkSize];
+    }
+
+    //! \brief adds an object with the given \p values of its columns, a new chunk is allocated when needed
+    //! \returns handle of the new object or an invalid handle when the pool already holds the maximum count
+    template <std::size_t ChunkSize, class... Columns>
+    PoolHandle BasicPool<ChunkSize, Columns...>::insert(Columns... values)
+    {
+        if (m_size >= m_max_count)
+        {
+            return {};
+        }
+        if (m_size == m_chunks.size() * ChunkSize)
+        {
+            m_chunks.push_back(std::make_unique<Chunk>());
+        }
+
+        std::uint32_t slot_index = m_freelist_head;
+        if (slot_index != PoolHandle::INVALID_INDEX)
+        {
+            m_freelist_head = m_slots[slot_index].dense_index;
+        }
+        else
+        {
+            slot_index = static_cast<std::uint32_t>(m_slots.size());
+            m_slots.push_back({});
+        }
+
+        const auto dense_index = m_size;
+        auto values_tuple = std::forward_as_tuple(std::move(values)...);
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            ((element<I>(dense_index) = std::move(std::get<I>(values_tuple))), ...);
+        }(std::index_sequence_for<Columns...>{});
+
+        m_slots[slot_index].dense_index = static_cast<std::uint32_t>(dense_index);
+        m_dense2slot.push_back(slot_index);
+        m_size++;
+        return {slot_index, m_slots[slot_index].generation};
+    }
+
+    //! \brief moves the last object into \p dense_index and frees the slot of the removed one
+    template <std::size_t ChunkSize, class... Columns>
+    void BasicPool<ChunkSize, Columns...>::removeDense(std::size_t dense_index)
+    {
+        const auto slot_index = m_dense2slot[dense_index];
+        const auto last_index = m_size - 1;
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            if (dense_index != last_index)
+            {
+                ((element<I>(dense_index) = std::move(element<I>(last_index))), ...);
+            }
+            ((element<I>(last_index) = Columns{}), ...); //! releases resources held by the removed object
+        }(std::index_sequence_for<Columns...>{});
+
+        if (dense_index != last_index)
+        {
+            m_dense2slot[dense_index] = m_dense2slot[last_index];
+            m_slots[m_dense2slot[dense_index]].dense_index = static_cast<std::uint32_t>(dense_index);
+        }
+        m_dense2slot.pop_back();
+
+        auto &slot = m_slots[slot_index];
+        slot.generation++; //! all existing handles to the slot become stale
+        slot.dense_index = m_freelist_head;
+        m_freelist_head = slot_index;
+        m_size--;
+    }
+
+    //! \returns false if the \p handle is stale or invalid
+    template <std::size_t ChunkSize, class... Columns>
+    bool BasicPool<ChunkSize, Columns...>::remove(PoolHandle handle)
+    {
+        if (!contains(handle))
+        {
+            return false;
+        }
+        removeDense(m_slots[handle.index].dense_index);
+        return true;
+    }
+
+    //! \brief removes, in a single pass, all objects for which \p predicate(Columns &...) returns true
+    //! \returns number of removed objects
+    template <std::size_t ChunkSize, class... Columns>
+    template <class Predicate>
+    std::size_t BasicPool<ChunkSize, Columns...>::removeIf(Predicate &&predicate)
+    {
+        const auto old_size = m_size;
+        std::size_t dense_index = 0;
+        while (dense_index < m_size)
+        {
+            bool removes = [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return predicate(element<I>(dense_index)...);
+            }(std::index_sequence_for<Columns...>{});
+
+            if (removes)
+            {
+                removeDense(dense_index); //! the moved object is tested in the next iteration
+            }
+            else
+            {
+                dense_index++;
+            }
+        }
+        return old_size - m_size;
+    }
+
+    //! \brief removes all objects, their handles become stale, allocated chunks are kept
+    template <std::size_t ChunkSize, class... Columns>
+    void BasicPool<ChunkSize, Columns...>::clear()
+    {
+        while (m_size > 0)
+        {
+            removeDense(m_size - 1);
+        }
+    }
+
+    //! \returns true if the \p handle refers to a live object
+    template <std::size_t ChunkSize, class... Columns>
+    bool BasicPool<ChunkSize, Columns...>::contains(PoolHandle handle) const
+    {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+    }
+
+    //! \returns pointer to the \p Column of the object referred to by \p handle, or nullptr if the handle is stale
+    template <std::size_t ChunkSize, class... Columns>
+    template <std::size_t Column>
+    typename BasicPool<ChunkSize, Columns...>::template ColumnType<Column> *BasicPool<ChunkSize, Columns...>::get(PoolHandle handle)
+    {
+        if (!contains(handle))
+        {
+            return nullptr;
+        }
+        return &element<Column>(m_slots[handle.index].dense_index);
+    }
+
+    //! \returns \p Column of the object at \p dense_index (which must be less than size())
+    template <std::size_t ChunkSize, class... Columns>
+    template <std::size_t Column>
+    typename BasicPool<ChunkSize, Columns...>::template ColumnType<Column> &BasicPool<ChunkSize, Columns...>::at(std::size_t dense_index)
+    {
+        return element<Column>(dense_index);
+    }
+
+    //! \returns handle of the object at \p dense_index
+    template <std::size_t ChunkSize, class... Columns>
+    PoolHandle BasicPool<ChunkSize, Columns...>::getHandle(std::size_t dense_index) const
+    {
+        auto slot_index = m_dense2slot.at(dense_index);
+        return {slot_index, m_slots[slot_index].generation};
+    }
+
+    //! \brief calls \p function(Columns &...) for every live object
+    template <std::size_t ChunkSize, class... Columns>
+    template <class Function>
+    void BasicPool<ChunkSize, Columns...>::forEach(Function &&function)
+    {
+        forEachChunk([&function](std::span<Columns>... columns)
+                     {
+            for (std::size_t i = 0; i < std::get<0>(std::tie(columns...)).size(); ++i)
+            {
+                function(columns[i]...);
+            } });
+    }
+
+    //! \brief calls \p function(std::span<Columns>...) for live objects of every chunk
+    //! \brief the spans are contiguous, so loops over them vectorize well
+    template <std::size_t ChunkSize, class... Columns>
+    template <class Function>
+    void BasicPool<ChunkSize, Columns...>::forEachChunk(Function &&function)
+    {
+        for (std::size_t first = 0; first < m_size; first += ChunkSize)
+        {
+            auto &chunk = *m_chunks[first / ChunkSize];
+            auto count = std::min(ChunkSize, m_size - first);
+            [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                function(std::span<Columns>(std::get<I>(chunk.columns).data(), count)...);
+            }(std::index_sequence_for<Columns...>{});
+        }
+    }
+
+    template <std::size_t ChunkSize, class... Columns>
+    std::size_t BasicPool<ChunkSize, Columns...>::size() const
+    {
+        return m_size;
+    }
+
+    //! \returns number of objects that fit into the allocated chunks
+    template <std::size_t ChunkSize, class... Columns>
+    std::size_t BasicPool<ChunkSize, Columns...>::capacity() const
+    {
+        return m_chunks.size() * ChunkSize;
+    }
+
+    //! \brief allocates chunks for \p count objects up front
+    template <std::size_t ChunkSize, class... Columns>
+    void BasicPool<ChunkSize, Columns...>::reserve(std::size_t count)
+    {
+        count = std::min(count, m_max_count);
+        while (capacity() < count)
+        {
+            m_chunks.push_back(std::make_unique<Chunk>());
+        }
+        m_slots.reserve(count);
+        m_dense2slot.reserve(count);
+    }
+
+    //! \brief sets maximum number of objects (NO_LIMIT by default), live objects above it are kept
+    template <std::size_t ChunkSize, class... Columns>
+    void BasicPool<ChunkSize, Columns...>::setMaxCount(std::size_t max_count)
+    {
+        m_max_count = std::min(max_count, NO_LIMIT);
+    }
+
+    template <std::size_t ChunkSize, class... Columns>
+    std::size_t BasicPool<ChunkSize, Columns...>::getMaxCount() const
+    {
+        return m_max_count;
+    }
+
+} // namespace utils
@@ -1,17 +1,35 @@
 #pragma once
 
+#include <atomic>
 #include <random>
 
+#include "Rng.h"
 #include "Vector2.h"
 
+//! \returns generator owned by the calling thread, so randf and randomPosInBox are safe to call from any thread
+//! \brief threads get different streams in the order they first ask for it
+inline utils::Rng &getThreadRng()
+{
+    static std::atomic<std::uint64_t> s_threads_count = 0;
+    thread_local utils::Rng rng(utils::Rng::DEFAULT_SEED, (1ULL << 63) | s_threads_count++);
+    return rng;
+}
+
+//! \returns generator for a new emitter, each call gets a different stream
+//! \brief emitters created in the same order get the same generators, so runs can be replayed
+inline utils::Rng makeEmitterRng()
+{
+    static std::atomic<std::uint64_t> s_emitters_count = 0;
+    return utils::Rng(utils::Rng::DEFAULT_SEED, s_emitters_count++);
+}
+
 inline float randf(const float min = 0, const float max = 1)
 {
-    return (rand() / static_cast<float>(RAND_MAX)) * (max - min) + min;
+    return getThreadRng().uniform(min, max);
 }
 
-inline Vec2 randomPosInBox(utils::Vector2f ul_corner,
+inline utils::Vector2f randomPosInBox(utils::Vector2f ul_corner,
                            utils::Vector2f box_size)
 {
-    return {ul_corner.x + rand() / static_cast<float>(RAND_MAX) * box_size.x,
-            ul_corner.y + rand() / static_cast<float>(RAND_MAX) * box_size.y};
+    return getThreadRng().inBox(ul_corner, box_size);
 }
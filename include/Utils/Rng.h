@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Vector2.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace utils
+{
+
+    //! \class Rng
+    //! \brief fast random generator with its own state, the same seed always gives the same numbers
+    //!  Single numbers come from PCG32. Bulk generation (fillUniform, fillGaussian) runs LANES independent
+    //!  xoshiro128+ generators side by side, so the compiler turns the loop into SIMD instructions.
+    //!  Give each emitter (or thread) its own Rng, one Rng must not be used by more threads at once.
+    //!  Satisfies UniformRandomBitGenerator, so it also works with the distributions of <random>
+    class Rng
+    {
+    public:
+        using result_type = std::uint32_t;
+        static constexpr std::size_t LANES = 8;
+        static constexpr std::uint64_t DEFAULT_SEED = 0x853c49e6748fea9bULL;
+
+    public:
+        explicit Rng(std::uint64_t seed = DEFAULT_SEED, std::uint64_t stream = 0);
+
+        void seed(std::uint64_t seed, std::uint64_t stream = 0);
+
+        std::uint32_t next();
+        float uniform();
+        float uniform(float min, float max);
+        int uniformInt(int min, int max);
+        float gaussian(float mean = 0.f, float stddev = 1.f);
+        Vector2f inBox(Vector2f ul_corner, Vector2f box_size);
+
+        void fillUniform(std::span<float> values, float min = 0.f, float max = 1.f);
+        void fillGaussian(std::span<float> values, float mean = 0.f, float stddev = 1.f);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+        result_type operator()() { return next(); }
+
+    private:
+        std::uint64_t m_state = 0;
+        std::uint64_t m_increment = 1; //!< selects the stream of PCG32, must be odd
+
+        //! states of the xoshiro128+ lanes, one array per state word, so that lanes sit next to each other
+        std::array<std::uint32_t, LANES> m_lanes0;
+        std::array<std::uint32_t, LANES> m_lanes1;
+        std::array<std::uint32_t, LANES> m_lanes2;
+        std::array<std::uint32_t, LANES> m_lanes3;
+
+        bool m_has_spare_gaussian = false;
+        float m_spare_gaussian = 0.f; //!< Box-Muller makes two numbers at once
+    };
+
+} // namespace utils
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RENDERER_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RENDERER_SIMD_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__) //! 32-bit NEON has no vector division
+#include <arm_neon.h>
+#define RENDERER_SIMD_NEON
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define RENDERER_SIMD_WASM
+#endif
+
+namespace utils::simd
+{
+
+#if defined(RENDERER_SIMD_AVX)
+    using NativeFloats = __m256;
+    constexpr std::size_t FLOATS_WIDTH = 8;
+    constexpr const char *INSTRUCTION_SET = "AVX";
+#elif defined(RENDERER_SIMD_SSE)
+    using NativeFloats = __m128;
+    constexpr std::size_t FLOATS_WIDTH = 4;
+    constexpr const char *INSTRUCTION_SET = "SSE2";
+#elif defined(RENDERER_SIMD_NEON)
+    using NativeFloats = float32x4_t;
+    constexpr std::size_t FLOATS_WIDTH = 4;
+    constexpr const char *INSTRUCTION_SET = "NEON";
+#elif defined(RENDERER_SIMD_WASM)
+    using NativeFloats = v128_t;
+    constexpr std::size_t FLOATS_WIDTH = 4;
+    constexpr const char *INSTRUCTION_SET = "WASM SIMD";
+#else
+    using NativeFloats = float;
+    constexpr std::size_t FLOATS_WIDTH = 1;
+    constexpr const char *INSTRUCTION_SET = "scalar";
+#endif
+
+    //! \struct Floats
+    //! \brief a pack of FLOATS_WIDTH floats processed by one instruction
+    //!  The widest instruction set enabled by the compiler flags is used (AVX, SSE2, NEON on AArch64 or WASM SIMD),
+    //!  without any of them a pack holds a single float. Kernels written with it compile for every target
+    struct Floats
+    {
+        NativeFloats v;
+    };
+
+    //! \returns pack of FLOATS_WIDTH floats starting at \p data (no alignment needed)
+    inline Floats load(const float *data)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_loadu_ps(data)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_loadu_ps(data)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vld1q_f32(data)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_v128_load(data)};
+#else
+        return {*data};
+#endif
+    }
+
+    inline void store(float *data, Floats values)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        _mm256_storeu_ps(data, values.v);
+#elif defined(RENDERER_SIMD_SSE)
+        _mm_storeu_ps(data, values.v);
+#elif defined(RENDERER_SIMD_NEON)
+        vst1q_f32(data, values.v);
+#elif defined(RENDERER_SIMD_WASM)
+        wasm_v128_store(data, values.v);
+#else
+        *data = values.v;
+#endif
+    }
+
+    //! \returns pack with all floats equal to \p value
+    inline Floats broadcast(float value)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_set1_ps(value)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_set1_ps(value)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vdupq_n_f32(value)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_splat(value)};
+#else
+        return {value};
+#endif
+    }
+
+    inline Floats operator+(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_add_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_add_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vaddq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_add(a.v, b.v)};
+#else
+        return {a.v + b.v};
+#endif
+    }
+
+    inline Floats operator-(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_sub_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_sub_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vsubq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_sub(a.v, b.v)};
+#else
+        return {a.v - b.v};
+#endif
+    }
+
+    inline Floats operator*(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_mul_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_mul_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vmulq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_mul(a.v, b.v)};
+#else
+        return {a.v * b.v};
+#endif
+    }
+
+    inline Floats operator/(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_div_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_div_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vdivq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_div(a.v, b.v)};
+#else
+        return {a.v / b.v};
+#endif
+    }
+
+    inline Floats min(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_min_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_min_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vminq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_pmin(a.v, b.v)};
+#else
+        return {b.v < a.v ? b.v : a.v};
+#endif
+    }
+
+    inline Floats max(Floats a, Floats b)
+    {
+#if defined(RENDERER_SIMD_AVX)
+        return {_mm256_max_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_SSE)
+        return {_mm_max_ps(a.v, b.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vmaxq_f32(a.v, b.v)};
+#elif defined(RENDERER_SIMD_WASM)
+        return {wasm_f32x4_pmax(a.v, b.v)};
+#else
+        return {a.v < b.v ? b.v : a.v};
+#endif
+    }
+
+    //! \returns \p a * \p b + \p c
+    inline Floats mulAdd(Floats a, Floats b, Floats c)
+    {
+#if defined(RENDERER_SIMD_AVX) && defined(__FMA__)
+        return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+#elif defined(RENDERER_SIMD_NEON)
+        return {vfmaq_f32(c.v, a.v, b.v)};
+#else
+        return a * b + c;
+#endif
+    }
+
+} // namespace utils::simd
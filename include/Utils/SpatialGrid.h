@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Vector2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+
+    //! \class SpatialGrid
+    //! \brief uniform grid of square cells over the bounding box of a set of points, for finding neighbours
+    //!  It is rebuilt from scratch (each frame) by a counting sort of the points by their cell, which is linear
+    //!  in the number of points. Points of one cell are stored next to each other, so a neighbour query reads
+    //!  a few short contiguous ranges. Queries do not change the grid, so many threads may query at once
+    class SpatialGrid
+    {
+    public:
+        explicit SpatialGrid(float cell_size = 10.f);
+
+        void setCellSize(float cell_size);
+        float getCellSize() const;
+
+        void build(std::span<const float> xs, std::span<const float> ys);
+        void clear();
+
+        template <class Function>
+        void forEachNeighbour(Vector2f center, float radius, Function &&function) const;
+
+        std::size_t size() const;
+
+    private:
+        int cellX(float x) const;
+        int cellY(float y) const;
+
+    private:
+        float m_cell_size = 10.f;
+        float m_inv_cell_size = 0.1f; //!< of the last build, cells get bigger when points are spread too far apart
+        float m_min_x = 0.f;
+        float m_min_y = 0.f;
+        int m_cells_x = 0;
+        int m_cells_y = 0;
+
+        std::vector<std::uint32_t> m_cell_starts;  //!< points of cell c are [m_cell_starts[c], m_cell_starts[c + 1])
+        std::vector<std::uint32_t> m_point_cells;  //!< cell of each point, only used during build
+        std::vector<std::uint32_t> m_indices;      //!< indices of the points sorted by their cell
+        std::vector<float> m_xs;                   //!< positions sorted by cell
+        std::vector<float> m_ys;
+    };
+
+    inline int SpatialGrid::cellX(float x) const
+    {
+        return std::clamp(static_cast<int>((x - m_min_x) * m_inv_cell_size), 0, m_cells_x - 1);
+    }
+
+    inline int SpatialGrid::cellY(float y) const
+    {
+        return std::clamp(static_cast<int>((y - m_min_y) * m_inv_cell_size), 0, m_cells_y - 1);
+    }
+
+    //! \brief calls \p function(index, offset) for every point closer than \p radius to \p center
+    //! \param center
+    //! \param radius
+    //! \param function     gets index of the point in the arrays given to build() and its position minus \p center
+    template <class Function>
+    void SpatialGrid::forEachNeighbour(Vector2f center, float radius, Function &&function) const
+    {
+        if (m_indices.empty())
+        {
+            return;
+        }
+        const float radius_sq = radius * radius;
+        const int first_x = cellX(center.x - radius);
+        const int last_x = cellX(center.x + radius);
+        const int first_y = cellY(center.y - radius);
+        const int last_y = cellY(center.y + radius);
+        for (int cell_y = first_y; cell_y <= last_y; ++cell_y)
+        {
+            //! cells of one row are next to each other, so the whole row is one range
+            const auto row = static_cast<std::size_t>(cell_y) * m_cells_x;
+            const auto begin = m_cell_starts[row + first_x];
+            const auto end = m_cell_starts[row + last_x + 1];
+            for (auto i = begin; i < end; ++i)
+            {
+                Vector2f offset = {m_xs[i] - center.x, m_ys[i] - center.y};
+                if (offset.x * offset.x + offset.y * offset.y < radius_sq)
+                {
+                    function(static_cast<std::size_t>(m_indices[i]), offset);
+                }
+            }
+        }
+    }
+
+} // namespace utils
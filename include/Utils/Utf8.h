@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+    //! \brief number of bytes of a UTF-8 sequence starting with a given byte, 0 for bytes which can not start one
+    //!  (continuation bytes, overlong 0xC0/0xC1 and 0xF5+ which would encode code points above U+10FFFF)
+    constexpr std::array<std::uint8_t, 256> UTF8_SEQUENCE_LENGTHS = []()
+    {
+        std::array<std::uint8_t, 256> lengths = {};
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            lengths[byte] = byte < 0x80 ? 1 : byte < 0xC2 ? 0 : byte < 0xE0 ? 2 : byte < 0xF0 ? 3 : byte < 0xF5 ? 4 : 0;
+        }
+        return lengths;
+    }();
+
+    constexpr wchar_t UTF_REPLACEMENT_CHARACTER = 0xFFFD;
+
+    //! \brief decodes \p utf8 into \p utf32, reusing its memory (nothing is allocated when its capacity suffices)
+    //!  Runs of ASCII are copied 8 bytes at a time, invalid sequences become U+FFFD.
+    //!  Where wchar_t has 16 bits (Windows), code points outside the BMP also become U+FFFD.
+    inline void decodeUtf8(std::string_view utf8, std::wstring &utf32)
+    {
+        utf32.resize(utf8.size()); //! every byte gives at most one code point
+        auto *src = reinterpret_cast<const unsigned char *>(utf8.data());
+        const auto *end = src + utf8.size();
+        wchar_t *dst = utf32.data();
+
+        while (src < end)
+        {
+            //! ASCII fast path: no byte of the chunk has the top bit set
+            while (end - src >= 8)
+            {
+                std::uint64_t chunk;
+                std::memcpy(&chunk, src, 8);
+                if (chunk & 0x8080808080808080ull)
+                {
+                    break;
+                }
+                for (int i = 0; i < 8; ++i)
+                {
+                    dst[i] = src[i];
+                }
+                src += 8;
+                dst += 8;
+            }
+            if (src == end)
+            {
+                break;
+            }
+
+            unsigned char lead = *src;
+            int length = UTF8_SEQUENCE_LENGTHS[lead];
+            if (length == 1)
+            {
+                *dst++ = lead;
+                src++;
+                continue;
+            }
+            if (length == 0 || end - src < length)
+            {
+                *dst++ = UTF_REPLACEMENT_CHARACTER;
+                src++;
+                continue;
+            }
+
+            //! the second byte has a narrower range after some leads (overlongs, surrogates, > U+10FFFF)
+            unsigned char second = src[1];
+            unsigned char second_min = lead == 0xE0 ? 0xA0 : lead == 0xF0 ? 0x90 : 0x80;
+            unsigned char second_max = lead == 0xED ? 0x9F : lead == 0xF4 ? 0x8F : 0xBF;
+            bool valid = second >= second_min && second <= second_max;
+            for (int i = 2; i < length; ++i)
+            {
+                valid &= (src[i] & 0xC0) == 0x80;
+            }
+            if (!valid)
+            {
+                *dst++ = UTF_REPLACEMENT_CHARACTER;
+                src++;
+                continue;
+            }
+
+            std::uint32_t code_point = lead & (0x7F >> length);
+            for (int i = 1; i < length; ++i)
+            {
+                code_point = (code_point << 6) | (src[i] & 0x3F);
+            }
+            if constexpr (sizeof(wchar_t) < 4)
+            {
+                code_point = code_point > 0xFFFF ? UTF_REPLACEMENT_CHARACTER : code_point;
+            }
+            *dst++ = static_cast<wchar_t>(code_point);
+            src += length;
+        }
+        utf32.resize(dst - utf32.data());
+    }
+
+    //! \brief encodes \p utf32 into \p utf8, reusing its memory (nothing is allocated when its capacity suffices)
+    inline void encodeUtf8(std::wstring_view utf32, std::string &utf8)
+    {
+        utf8.resize(utf32.size() * 4); //! every code point gives at most four bytes
+        char *dst = utf8.data();
+        for (auto c : utf32)
+        {
+            auto code_point = static_cast<std::uint32_t>(c);
+            if ((code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+            {
+                code_point = UTF_REPLACEMENT_CHARACTER;
+            }
+
+            if (code_point < 0x80)
+            {
+                *dst++ = static_cast<char>(code_point);
+            }
+            else if (code_point < 0x800)
+            {
+                *dst++ = static_cast<char>(0xC0 | (code_point >> 6));
+                *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else if (code_point < 0x10000)
+            {
+                *dst++ = static_cast<char>(0xE0 | (code_point >> 12));
+                *dst++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else
+            {
+                *dst++ = static_cast<char>(0xF0 | (code_point >> 18));
+                *dst++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                *dst++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+        utf8.resize(dst - utf8.data());
+    }
+
+    inline std::wstring decodeUtf8(std::string_view utf8)
+    {
+        std::wstring utf32;
+        decodeUtf8(utf8, utf32);
+        return utf32;
+    }
+
+    inline std::string encodeUtf8(std::wstring_view utf32)
+    {
+        std::string utf8;
+        encodeUtf8(utf32, utf8);
+        return utf8;
+    }
+} // namespace utils
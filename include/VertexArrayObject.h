@@ -17,6 +17,7 @@ struct SpriteInstance
     Vec2 tex_coords = {0, 0};
     Vec2 tex_size = {0, 0};
     ColorByte color = {255, 255, 255, 255};
+    int texture_layer = 0; //!< layer of an ArrayTexture (ignored by shaders sampling ordinary textures)
 };
 //! \struct TextInstance
 //! \brief data that get sent into text shaders
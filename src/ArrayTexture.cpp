@@ -0,0 +1,178 @@
+#include "ArrayTexture.h"
+
+#include "IncludesGl.h"
+
+#include "../external/stbimage/stb_image.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+//! \brief constructs an empty array texture, see create()
+ArrayTexture::ArrayTexture(int width, int height, int max_layers_count, TextureOptions options)
+{
+    create(width, height, max_layers_count, options);
+}
+
+ArrayTexture::~ArrayTexture()
+{
+    glDeleteTextures(1, &m_texture_handle);
+    glCheckError();
+}
+
+//! \brief allocates storage for \p max_layers_count images of dimensions \p width x \p height
+//! \param width
+//! \param height
+//! \param max_layers_count maximum number of images the texture can hold (is limited by GL_MAX_ARRAY_TEXTURE_LAYERS)
+//! \param options  struct containing how the texture should be sampled
+void ArrayTexture::create(int width, int height, int max_layers_count, TextureOptions options)
+{
+    glDeleteTextures(1, &m_texture_handle);
+
+    m_options = options;
+    m_options.format = TextureFormat::RGBA;
+    m_options.internal_format = TextureFormat::RGBA;
+    m_options.data_type = TextureDataTypes::UByte;
+    m_width = width;
+    m_height = height;
+    m_layers_count = 0;
+    m_max_layers_count = max_layers_count;
+
+    int full_chain_levels = std::bit_width(static_cast<unsigned int>(std::max(width, height))) - 1;
+    m_options.mipmap_levels = std::clamp(options.mipmap_levels, 0, full_chain_levels);
+
+    glGenTextures(1, &m_texture_handle);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_handle);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_options.mipmap_levels + 1, GL_RGBA8, width, height, max_layers_count);
+    glCheckError();
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, getGLCode(m_options.wrap_x));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, getGLCode(m_options.wrap_y));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, getGLCode(m_options.min_param));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, getGLCode(m_options.mag_param));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_options.mipmap_levels);
+    glCheckError();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+//! \brief loads image in \p image_file into the next free layer
+//! \param image_file   path to the image, it has to have the same size as the texture
+//! \returns index of the layer or -1 when the image could not be added
+int ArrayTexture::addLayer(const std::filesystem::path &image_file)
+{
+#ifdef __ANDROID__
+    // On Android, open from assets
+    SDL_RWops *rw = SDL_RWFromFile(image_file.string().c_str(), "rb");
+    if (!rw)
+    {
+        std::cout << "Failed to open texture " << image_file << ": " << SDL_GetError() << "\n";
+        return -1;
+    }
+    std::vector<unsigned char> buffer(SDL_RWsize(rw));
+    auto read_bytes = SDL_RWread(rw, buffer.data(), 1, buffer.size());
+    SDL_RWclose(rw);
+    if (read_bytes != buffer.size())
+    {
+        std::cout << "Failed to read texture " << image_file << "\n";
+        return -1;
+    }
+    return addLayer(buffer.data(), buffer.size());
+#else
+    int width, height, channels_count;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char *data = stbi_load(image_file.string().c_str(), &width, &height, &channels_count, 4);
+    if (!data)
+    {
+        std::cout << "Error loading texture: " << image_file << "\n";
+        return -1;
+    }
+    auto layer = uploadLayer(data, width, height);
+    stbi_image_free(data);
+    return layer;
+#endif
+}
+
+//! \brief decodes an encoded image (png, jpg ...) in \p buffer into the next free layer
+//! \param buffer   encoded image data, the image has to have the same size as the texture
+//! \param size     size of the \p buffer in bytes
+//! \returns index of the layer or -1 when the image could not be added
+int ArrayTexture::addLayer(const unsigned char *buffer, std::size_t size)
+{
+    int width, height, channels_count;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char *data = stbi_load_from_memory(buffer, size, &width, &height, &channels_count, 4);
+    if (!data)
+    {
+        std::cout << "Error loading texture from memory\n";
+        return -1;
+    }
+    auto layer = uploadLayer(data, width, height);
+    stbi_image_free(data);
+    return layer;
+}
+
+int ArrayTexture::uploadLayer(const unsigned char *pixels, int width, int height)
+{
+    if (m_texture_handle == 0 || m_layers_count >= m_max_layers_count)
+    {
+        std::cout << "No free layer in the array texture!\n";
+        return -1;
+    }
+    if (width != m_width || height != m_height)
+    {
+        std::cout << "Image of size " << width << "x" << height << " does not fit into the array texture of size "
+                  << m_width << "x" << m_height << "\n";
+        return -1;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_handle);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_layers_count, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glCheckError();
+    if (m_options.mipmap_levels > 0)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glCheckError();
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return m_layers_count++;
+}
+
+//! \brief bind the texture to a GL slot specified by: \p slot
+//! \param slot
+void ArrayTexture::bind(int slot)
+{
+    assert(m_texture_handle != 0); //! has to be generated first
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture_handle);
+    glCheckError();
+}
+
+//! \returns size of a single layer
+Vec2 ArrayTexture::getSize() const
+{
+    return {static_cast<float>(m_width), static_cast<float>(m_height)};
+}
+
+int ArrayTexture::getLayersCount() const
+{
+    return m_layers_count;
+}
+
+int ArrayTexture::getMaxLayersCount() const
+{
+    return m_max_layers_count;
+}
+
+TextureHandle ArrayTexture::getHandle() const
+{
+    return m_texture_handle;
+}
+
+const TextureOptions &ArrayTexture::getOptions() const
+{
+    return m_options;
+}
@@ -0,0 +1,589 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__ANDROID__) || defined(__EMSCRIPTEN__)
+#include <SDL2/SDL.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//! layout of the file:
+//!  header:    char[4] magic | u32 version | u32 entry_count | u32 toc_size
+//!  toc:       entry_count x (u32 name_length | name bytes | u32 flags | u64 offset | u64 size | u64 raw_size)
+//!  blobs:     each starts at a multiple of ASSET_PACK_ALIGNMENT
+//!  all integers are little-endian
+constexpr char ASSET_PACK_MAGIC[4] = {'R', 'P', 'A', 'K'};
+constexpr std::size_t ASSET_PACK_HEADER_SIZE = 4 + 3 * sizeof(std::uint32_t);
+
+template <class T>
+static bool readValue(const unsigned char *data, std::size_t size, std::size_t &pos, T &value)
+{
+    if (pos + sizeof(T) > size)
+    {
+        return false;
+    }
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+template <class T>
+static void writeValue(std::vector<unsigned char> &data, T value)
+{
+    const auto *bytes = reinterpret_cast<const unsigned char *>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+bool AssetPack::Entry::isCompressed() const
+{
+    return flags & static_cast<std::uint32_t>(AssetPackFlag::Lz4);
+}
+
+//! \brief opens the pack at \p pack_path
+//! \throws std::runtime_error when the file is not a valid pack
+AssetPack::AssetPack(const std::filesystem::path &pack_path)
+{
+    if (!open(pack_path))
+    {
+        throw std::runtime_error("Could not open asset pack: " + pack_path.string());
+    }
+}
+
+AssetPack::~AssetPack()
+{
+    close();
+}
+
+AssetPack::AssetPack(AssetPack &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+AssetPack &AssetPack::operator=(AssetPack &&other) noexcept
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_file_handle = std::exchange(other.m_file_handle, nullptr);
+    m_mapping_handle = std::exchange(other.m_mapping_handle, nullptr);
+    m_owned_bytes = std::move(other.m_owned_bytes);
+    m_entries = std::move(other.m_entries);
+    m_decompressed = std::move(other.m_decompressed);
+    return *this;
+}
+
+//! \brief maps the file at \p pack_path into memory and reads the table of contents
+//! \returns true if the pack was succesfully opened
+bool AssetPack::open(const std::filesystem::path &pack_path)
+{
+    close();
+    if (!map(pack_path))
+    {
+        return false;
+    }
+    if (!readTableOfContents())
+    {
+        std::cout << "Warning: " << pack_path << " is not a valid asset pack!" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close()
+{
+    unmap();
+    m_entries.clear();
+    m_decompressed.clear();
+}
+
+bool AssetPack::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool AssetPack::contains(const std::string &name) const
+{
+    return m_entries.contains(name);
+}
+
+//! \returns bytes of the entry \p name, the span points directly into the mapped file
+//! \returns an empty span if there is no such entry
+std::span<const unsigned char> AssetPack::get(const std::string &name) const
+{
+    auto entry_it = m_entries.find(name);
+    if (entry_it == m_entries.end())
+    {
+        return {};
+    }
+    const auto &entry = entry_it->second;
+    if (!entry.isCompressed())
+    {
+        return {m_data + entry.offset, entry.size};
+    }
+
+    auto cached_it = m_decompressed.find(name);
+    if (cached_it == m_decompressed.end())
+    {
+        std::vector<unsigned char> bytes(entry.raw_size);
+        if (!lz4DecompressBlock(m_data + entry.offset, entry.size, bytes.data(), bytes.size()))
+        {
+            std::cout << "Warning: corrupted LZ4 entry: " << name << std::endl;
+            return {};
+        }
+        cached_it = m_decompressed.emplace(name, std::move(bytes)).first;
+    }
+    return {cached_it->second.data(), cached_it->second.size()};
+}
+
+//! \returns the entry \p name viewed as text (useful for shader code)
+std::string_view AssetPack::getString(const std::string &name) const
+{
+    auto bytes = get(name);
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+const std::unordered_map<std::string, AssetPack::Entry> &AssetPack::getEntries() const
+{
+    return m_entries;
+}
+
+bool AssetPack::readTableOfContents()
+{
+    if (m_size < ASSET_PACK_HEADER_SIZE || std::memcmp(m_data, ASSET_PACK_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+
+    std::size_t pos = 4;
+    std::uint32_t version, entry_count, toc_size;
+    readValue(m_data, m_size, pos, version);
+    readValue(m_data, m_size, pos, entry_count);
+    readValue(m_data, m_size, pos, toc_size);
+    if (version != ASSET_PACK_VERSION || ASSET_PACK_HEADER_SIZE + toc_size > m_size)
+    {
+        return false;
+    }
+
+    m_entries.reserve(entry_count);
+    for (std::uint32_t i = 0; i < entry_count; ++i)
+    {
+        std::uint32_t name_length;
+        if (!readValue(m_data, m_size, pos, name_length) || pos + name_length > m_size)
+        {
+            return false;
+        }
+        std::string name(reinterpret_cast<const char *>(m_data + pos), name_length);
+        pos += name_length;
+
+        Entry entry;
+        if (!readValue(m_data, m_size, pos, entry.flags) ||
+            !readValue(m_data, m_size, pos, entry.offset) ||
+            !readValue(m_data, m_size, pos, entry.size) ||
+            !readValue(m_data, m_size, pos, entry.raw_size))
+        {
+            return false;
+        }
+        if (entry.offset + entry.size > m_size)
+        {
+            return false;
+        }
+        m_entries[name] = entry;
+    }
+    return true;
+}
+
+#if defined(_WIN32)
+bool AssetPack::map(const std::filesystem::path &pack_path)
+{
+    HANDLE file = CreateFileW(pack_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    m_data = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_size = static_cast<std::size_t>(file_size.QuadPart);
+    m_file_handle = file;
+    m_mapping_handle = mapping;
+    return true;
+}
+
+void AssetPack::unmap()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping_handle);
+        CloseHandle(m_file_handle);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file_handle = nullptr;
+    m_mapping_handle = nullptr;
+}
+#elif defined(__ANDROID__) || defined(__EMSCRIPTEN__)
+//! Android keeps resources inside the apk and emscripten's file system lives in memory anyway
+//! so we just read the whole pack once
+bool AssetPack::map(const std::filesystem::path &pack_path)
+{
+    SDL_RWops *rw = SDL_RWFromFile(pack_path.string().c_str(), "rb");
+    if (!rw)
+    {
+        SDL_Log("Failed to open %s: %s", pack_path.string().c_str(), SDL_GetError());
+        return false;
+    }
+
+    Sint64 size = SDL_RWsize(rw);
+    m_owned_bytes.resize(size);
+    Sint64 read_bytes = SDL_RWread(rw, m_owned_bytes.data(), 1, size);
+    SDL_RWclose(rw);
+    if (read_bytes != size)
+    {
+        m_owned_bytes.clear();
+        return false;
+    }
+    m_data = m_owned_bytes.data();
+    m_size = m_owned_bytes.size();
+    return true;
+}
+
+void AssetPack::unmap()
+{
+    m_owned_bytes.clear();
+    m_owned_bytes.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+}
+#else
+bool AssetPack::map(const std::filesystem::path &pack_path)
+{
+    int file = ::open(pack_path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat file_info;
+    if (fstat(file, &file_info) != 0 || file_info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+    void *mapping = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); //! the mapping stays valid after closing the descriptor
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    m_data = static_cast<const unsigned char *>(mapping);
+    m_size = static_cast<std::size_t>(file_info.st_size);
+    return true;
+}
+
+void AssetPack::unmap()
+{
+    if (m_data)
+    {
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+#endif
+
+//! \brief adds \p bytes into the pack under \p name
+//! \param compress     the entry is stored as LZ4 block, but only if that actually makes it smaller
+void AssetPackWriter::add(const std::string &name, std::vector<unsigned char> bytes, bool compress)
+{
+    PendingEntry entry;
+    entry.name = name;
+    entry.raw_size = bytes.size();
+    if (compress && !bytes.empty())
+    {
+        auto compressed = lz4CompressBlock(bytes.data(), bytes.size());
+        if (compressed.size() < bytes.size())
+        {
+            bytes = std::move(compressed);
+            entry.flags |= static_cast<std::uint32_t>(AssetPackFlag::Lz4);
+        }
+    }
+    entry.bytes = std::move(bytes);
+    m_entries.push_back(std::move(entry));
+}
+
+//! \returns true if the file at \p file_path could be read
+bool AssetPackWriter::addFile(const std::string &name, const std::filesystem::path &file_path, bool compress)
+{
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    add(name, std::move(bytes), compress);
+    return true;
+}
+
+//! \brief adds all files in \p directory (recursively), entries are named by their path relative to \p directory
+//! \returns number of added files
+std::size_t AssetPackWriter::addDirectory(const std::filesystem::path &directory, bool compress)
+{
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end()); //! makes the output reproducible
+
+    std::size_t added_count = 0;
+    for (const auto &file : files)
+    {
+        auto name = std::filesystem::relative(file, directory).generic_string();
+        added_count += addFile(name, file, compress);
+    }
+    return added_count;
+}
+
+//! \brief writes all added entries into a pack at \p pack_path
+//! \returns true if the file was written
+bool AssetPackWriter::write(const std::filesystem::path &pack_path) const
+{
+    auto align = [](std::uint64_t offset)
+    { return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT; };
+
+    std::uint64_t toc_size = 0;
+    for (const auto &entry : m_entries)
+    {
+        toc_size += sizeof(std::uint32_t) + entry.name.size() + sizeof(std::uint32_t) + 3 * sizeof(std::uint64_t);
+    }
+
+    std::vector<unsigned char> data;
+    data.insert(data.end(), ASSET_PACK_MAGIC, ASSET_PACK_MAGIC + 4);
+    writeValue(data, ASSET_PACK_VERSION);
+    writeValue(data, static_cast<std::uint32_t>(m_entries.size()));
+    writeValue(data, static_cast<std::uint32_t>(toc_size));
+
+    std::uint64_t blob_offset = align(ASSET_PACK_HEADER_SIZE + toc_size);
+    for (const auto &entry : m_entries)
+    {
+        writeValue(data, static_cast<std::uint32_t>(entry.name.size()));
+        data.insert(data.end(), entry.name.begin(), entry.name.end());
+        writeValue(data, entry.flags);
+        writeValue(data, blob_offset);
+        writeValue(data, static_cast<std::uint64_t>(entry.bytes.size()));
+        writeValue(data, entry.raw_size);
+        blob_offset = align(blob_offset + entry.bytes.size());
+    }
+
+    for (const auto &entry : m_entries)
+    {
+        data.resize(align(data.size()), 0);
+        data.insert(data.end(), entry.bytes.begin(), entry.bytes.end());
+    }
+
+    std::ofstream file(pack_path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+//! \brief compresses \p source into a single LZ4 block (greedy matching, no frame header)
+//! \returns the compressed block
+std::vector<unsigned char> lz4CompressBlock(const unsigned char *source, std::size_t size)
+{
+    constexpr int HASH_LOG = 16;
+    constexpr std::size_t MIN_MATCH = 4;
+    constexpr std::size_t LAST_LITERALS = 5; //! format requires the last 5 bytes to be literals
+    constexpr std::size_t MATCH_FIND_LIMIT = 12;
+    constexpr std::size_t MAX_OFFSET = 65535;
+
+    std::vector<unsigned char> out;
+    out.reserve(size + size / 255 + 16);
+
+    auto read32 = [source](std::size_t pos)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, source + pos, sizeof(value));
+        return value;
+    };
+    auto hash = [](std::uint32_t value)
+    { return (value * 2654435761u) >> (32 - HASH_LOG); };
+    auto writeLength = [&out](std::size_t length)
+    {
+        while (length >= 255)
+        {
+            out.push_back(255);
+            length -= 255;
+        }
+        out.push_back(static_cast<unsigned char>(length));
+    };
+
+    std::size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT)
+    {
+        std::vector<std::int64_t> table(1 << HASH_LOG, -1);
+        std::size_t pos = 0;
+        const std::size_t match_limit = size - MATCH_FIND_LIMIT;
+        while (pos < match_limit)
+        {
+            auto sequence = read32(pos);
+            auto &slot = table[hash(sequence)];
+            auto candidate = slot;
+            slot = static_cast<std::int64_t>(pos);
+            if (candidate < 0 || pos - candidate > MAX_OFFSET || read32(candidate) != sequence)
+            {
+                pos++;
+                continue;
+            }
+
+            std::size_t match_length = MIN_MATCH;
+            while (pos + match_length < size - LAST_LITERALS && source[candidate + match_length] == source[pos + match_length])
+            {
+                match_length++;
+            }
+
+            std::size_t literal_length = pos - anchor;
+            std::size_t match_code = match_length - MIN_MATCH;
+            out.push_back(static_cast<unsigned char>((std::min<std::size_t>(literal_length, 15) << 4) |
+                                                     std::min<std::size_t>(match_code, 15)));
+            if (literal_length >= 15)
+            {
+                writeLength(literal_length - 15);
+            }
+            out.insert(out.end(), source + anchor, source + pos);
+
+            std::size_t offset = pos - candidate;
+            out.push_back(static_cast<unsigned char>(offset & 0xff));
+            out.push_back(static_cast<unsigned char>(offset >> 8));
+            if (match_code >= 15)
+            {
+                writeLength(match_code - 15);
+            }
+
+            pos += match_length;
+            anchor = pos;
+        }
+    }
+
+    //! last sequence contains only literals
+    std::size_t literal_length = size - anchor;
+    out.push_back(static_cast<unsigned char>(std::min<std::size_t>(literal_length, 15) << 4));
+    if (literal_length >= 15)
+    {
+        writeLength(literal_length - 15);
+    }
+    out.insert(out.end(), source + anchor, source + size);
+    return out;
+}
+
+//! \brief decompresses a single LZ4 block \p source into \p destination
+//! \returns true if the block was valid and decompressed into exactly \p destination_size bytes
+bool lz4DecompressBlock(const unsigned char *source, std::size_t size, unsigned char *destination, std::size_t destination_size)
+{
+    std::size_t in = 0;
+    std::size_t out = 0;
+
+    auto readLength = [&](std::size_t &length)
+    {
+        unsigned char byte;
+        do
+        {
+            if (in >= size)
+            {
+                return false;
+            }
+            byte = source[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < size)
+    {
+        unsigned char token = source[in++];
+
+        std::size_t literal_length = token >> 4;
+        if (literal_length == 15 && !readLength(literal_length))
+        {
+            return false;
+        }
+        if (in + literal_length > size || out + literal_length > destination_size)
+        {
+            return false;
+        }
+        if (literal_length > 0) //! destination may be null for an empty entry
+        {
+            std::memcpy(destination + out, source + in, literal_length);
+        }
+        in += literal_length;
+        out += literal_length;
+
+        if (in == size) //! last sequence has no match
+        {
+            break;
+        }
+
+        if (in + 2 > size)
+        {
+            return false;
+        }
+        std::size_t offset = source[in] | (source[in + 1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out)
+        {
+            return false;
+        }
+
+        std::size_t match_length = token & 15;
+        if (match_length == 15 && !readLength(match_length))
+        {
+            return false;
+        }
+        match_length += 4;
+        if (out + match_length > destination_size)
+        {
+            return false;
+        }
+        //! byte by byte because the match may overlap the bytes being written
+        for (std::size_t i = 0; i < match_length; ++i)
+        {
+            destination[out + i] = destination[out - offset + i];
+        }
+        out += match_length;
+    }
+
+    return out == destination_size;
+}
@@ -2,6 +2,21 @@
 
 #include "IncludesGl.h"
 
+#include <algorithm>
+
+//! \brief binds each nonzero handle in \p textures to the slot given by its index
+static void bindTextures(const TextureArray &textures, TextureTarget texture_target)
+{
+    for (int tex_id = 0; tex_id < textures.size(); ++tex_id)
+    {
+        if (textures[tex_id] != 0)
+        {
+            glActiveTexture(GL_TEXTURE0 + tex_id);
+            glBindTexture(getGLCode(texture_target), textures[tex_id]);
+            glCheckError();
+        }
+    }
+}
 
 BatchI::~BatchI()
 {
@@ -47,7 +62,7 @@ std::shared_ptr<BatchI> makeTextBatch()
     return std::make_unique<InstancedBatch>(vertex_data, layout);
 }
 
-void InstancedBatch::flush(View &view, Shader &shader, TextureArray textures)
+void InstancedBatch::flush(View &view, Shader &shader, TextureArray textures, TextureTarget texture_target)
 {
     if (m_instance_count == 0) //! no drawing of empty batches
     {
@@ -56,25 +71,23 @@ void InstancedBatch::flush(View &view, Shader &shader, TextureArray textures)
     shader.setUniform("u_view_projection", view.getMatrix());
     shader.use();
 
-    for (int tex_id = 0; tex_id < textures.size(); ++tex_id)
-    {
-        if (textures[tex_id] != 0)
-        {
-            glActiveTexture(GL_TEXTURE0 + tex_id); 
-            glBindTexture(GL_TEXTURE_2D, textures[tex_id]);
-            glCheckError();
-        }
-    }
+    bindTextures(textures, texture_target);
 
     //! send data to GPU and do the Draw Call
     glBindVertexArray(m_vao);
     glBindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
     glCheckError();
-    glBufferSubData(GL_ARRAY_BUFFER, 0, m_layout.instance_size * m_instance_count, m_instance_data.data());
-    glCheckError();
-    //! the actual draw call
-    glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertex_count, m_instance_count);
-    glCheckError();
+    //! the instance buffer holds at most max_instance_count instances, so bigger batches take more draw calls
+    for (std::size_t first = 0; first < m_instance_count; first += m_layout.max_instance_count)
+    {
+        auto count = std::min(m_layout.max_instance_count, m_instance_count - first);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_layout.instance_size * count,
+                        m_instance_data.data() + m_layout.instance_size * first);
+        glCheckError();
+        //! the actual draw call
+        glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertex_count, count);
+        glCheckError();
+    }
     //! reset instance count (Should we add option to also reset vertex count?)
     m_instance_count = 0;
     m_instance_data.clear();
@@ -82,7 +95,17 @@ void InstancedBatch::flush(View &view, Shader &shader, TextureArray textures)
     glBindVertexArray(0);
 }
 
-void VertexBatch::flush(View &view, Shader &shader, TextureArray textures)
+bool InstancedBatch::isEmpty() const
+{
+    return m_instance_count == 0;
+}
+
+bool VertexBatch::isEmpty() const
+{
+    return m_vertex_count == 0;
+}
+
+void VertexBatch::flush(View &view, Shader &shader, TextureArray textures, TextureTarget texture_target)
 {
     if (m_vertex_count == 0) //! no drawing of empty batches
     {
@@ -91,15 +114,7 @@ void VertexBatch::flush(View &view, Shader &shader, TextureArray textures)
     shader.setUniform("u_view_projection", view.getMatrix());
     shader.use();
 
-    for (int tex_id = 0; tex_id < textures.size(); ++tex_id)
-    {
-        if (textures[tex_id] != 0)
-        {
-            glActiveTexture(GL_TEXTURE0 + tex_id); //! font texture;
-            glBindTexture(GL_TEXTURE_2D, textures[tex_id]);
-            glCheckError();
-        }
-    }
+    bindTextures(textures, texture_target);
 
     //! send data to GPU and do the Draw Call
     glBindVertexArray(m_vao);
@@ -128,6 +143,13 @@ void BatchI::addInstance(void *instance_data, std::size_t data_size)
     m_instance_data.insert(m_instance_data.end(), (std::byte *)instance_data, (std::byte *)(instance_data) + data_size);
 }
 
+void BatchI::addInstances(const void *instances_data, std::size_t instances_count, std::size_t instance_size)
+{
+    m_instance_count += instances_count;
+    m_instance_data.insert(m_instance_data.end(), (const std::byte *)instances_data,
+                           (const std::byte *)(instances_data) + instances_count * instance_size);
+}
+
 GLuint BatchI::initVertexArrayObject(VAOId layout)
 {
     glGenVertexArrays(1, &m_vao);
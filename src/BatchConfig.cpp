@@ -34,5 +34,7 @@ bool BatchConfig::operator==(const BatchConfig &other) const
     bool shaders_same = other.shader_id == shader_id;
     bool textures_same = std::equal(texture_ids.begin(), texture_ids.end(), std::begin(other.texture_ids));
     bool drawtypes_same = draw_type == other.draw_type;
-    return shaders_same && textures_same && drawtypes_same;
+    bool targets_same = texture_target == other.texture_target;
+    bool blends_same = blend_params == other.blend_params;
+    return shaders_same && textures_same && drawtypes_same && targets_same && blends_same;
 }
\ No newline at end of file
@@ -29,8 +29,8 @@ void main()
     vec2 rotated_pos = vec2(cos(a_angle) * scaled_pos.x - sin(a_angle) * scaled_pos.y,
                             +sin(a_angle) * scaled_pos.x + cos(a_angle) * scaled_pos.y);
     gl_Position = u_view_projection * vec4(rotated_pos + a_translation, 0., 1.0);
-    float char_count = float(textureSize(u_charmap, 0).x);
-    vec4 glyph_tex_rect = texelFetch(u_charmap, ivec2(a_charcode, 0), 0);
+    int charmap_width = textureSize(u_charmap, 0).x;
+    vec4 glyph_tex_rect = texelFetch(u_charmap, ivec2(a_charcode % charmap_width, a_charcode / charmap_width), 0);
     vec2 tex_coord = glyph_tex_rect.rg;
     vec2 tex_dim = glyph_tex_rect.ba;
     v_tex_coord = vec2(tex_coord.x + tex_dim.x * a_tex_coord.x, tex_coord.y - tex_dim.y * (1.-a_tex_coord.y));
@@ -95,6 +95,139 @@ void main()
 }
 )V0G0N";
 
+//! quad of a ParticleInstance, a_scale holds half of its size and a_angle is in degrees
+constexpr const char *vertex_particle_code = R"V0G0N(#version 300 es
+precision highp float;
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_tex_pos;
+layout(location = 2) in vec2 a_translation;
+layout(location = 3) in vec2 a_scale;
+layout(location = 4) in float a_angle;
+layout(location = 5) in vec4 a_color;
+out vec2 v_tex_coord;
+out vec4 v_color;
+uniform mat4 u_view_projection ;
+void main()
+{
+   float angle = radians(a_angle);
+   vec2 scaled_pos = a_scale * a_position;
+   vec2 rotated_pos = vec2(cos(angle) * scaled_pos.x - sin(angle) * scaled_pos.y,
+                               +sin(angle) * scaled_pos.x + cos(angle) * scaled_pos.y);
+   gl_Position = u_view_projection * vec4(rotated_pos + a_translation, 0., 1.0);
+   v_tex_coord = a_tex_pos;
+   v_color = a_color;
+}
+)V0G0N";
+
+//! one simulation step of GpuParticles, outputs are captured by transform feedback into the other state buffer
+//! slots from u_emit_first (u_emit_count of them, wrapping around) get newborn particles
+constexpr const char *vertex_gpu_particles_simulation_code = R"V0G0N(#version 300 es
+precision highp float;
+layout(location = 0) in vec2 a_pos;
+layout(location = 1) in vec2 a_vel;
+layout(location = 2) in float a_time;
+layout(location = 3) in float a_life_time;
+out vec2 v_pos;
+out vec2 v_vel;
+out float v_time;
+out float v_life_time;
+uniform float u_dt;
+uniform float u_seed;
+uniform int u_emit_first;
+uniform int u_emit_count;
+uniform int u_capacity;
+uniform vec2 u_spawn_pos;
+uniform vec2 u_speed_range;
+uniform float u_lifetime;
+uniform vec2 u_acceleration;
+uniform float u_drag;
+float random(float x)
+{
+    return fract(sin(x * 12.9898 + u_seed * 78.233) * 43758.5453);
+}
+void main()
+{
+    int slot = (gl_VertexID - u_emit_first + u_capacity) % u_capacity;
+    if (slot < u_emit_count)
+    {
+        float angle = 6.2831853 * random(float(gl_VertexID));
+        float speed = mix(u_speed_range.x, u_speed_range.y, random(float(gl_VertexID) + 0.5));
+        v_pos = u_spawn_pos;
+        v_vel = speed * vec2(cos(angle), sin(angle));
+        v_time = 0.;
+        v_life_time = u_lifetime;
+        return;
+    }
+    vec2 vel = (a_vel + u_acceleration * u_dt) * max(1. - u_drag * u_dt, 0.);
+    v_vel = vel;
+    v_pos = a_pos + vel * u_dt;
+    v_time = a_time + u_dt;
+    v_life_time = a_life_time;
+}
+)V0G0N";
+
+//! the simulation is never rasterized, but GLES needs a fragment shader to link the program
+constexpr const char *fragment_gpu_particles_simulation_code = R"V0G0N(#version 300 es
+precision highp float;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(0.);
+}
+)V0G0N";
+
+//! draws GpuParticles straight from the state buffer, dead particles collapse into a point
+constexpr const char *vertex_gpu_particles_code = R"V0G0N(#version 300 es
+precision highp float;
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_tex_pos;
+layout(location = 2) in vec2 a_translation;
+layout(location = 3) in float a_time;
+layout(location = 4) in float a_life_time;
+out vec2 v_tex_coord;
+out vec4 v_color;
+uniform mat4 u_view_projection;
+uniform vec4 u_init_color;
+uniform vec4 u_final_color;
+uniform vec2 u_size;
+void main()
+{
+    float ratio = clamp(a_time / max(a_life_time, 0.0001), 0., 1.);
+    float alive = a_time <= a_life_time ? 1. : 0.;
+    float half_size = 0.5 * alive * mix(u_size.x, u_size.y, ratio);
+    gl_Position = u_view_projection * vec4(a_translation + half_size * a_position, 0., 1.0);
+    v_tex_coord = a_tex_pos;
+    v_color = mix(u_init_color, u_final_color, ratio);
+}
+)V0G0N";
+
+constexpr const char *vertex_sprite_array_code = R"V0G0N(#version 300 es
+precision highp float;
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_tex_pos;
+layout(location = 2) in vec2 a_translation;
+layout(location = 3) in vec2 a_scale;
+layout(location = 4) in float a_angle;
+layout(location = 5) in vec2 a_tex_coord;
+layout(location = 6) in vec2 a_tex_dim;
+layout(location = 7) in vec4 a_color;
+layout(location = 8) in int a_layer;
+out vec2 v_tex_coord;
+out vec4 v_color;
+flat out int v_layer;
+uniform mat4 u_view_projection ;
+void main()
+{
+   vec2 scaled_pos = a_scale * a_position;
+   vec2 rotated_pos = vec2(cos(a_angle) * scaled_pos.x - sin(a_angle) * scaled_pos.y,
+                               +sin(a_angle) * scaled_pos.x + cos(a_angle) * scaled_pos.y);
+   gl_Position = u_view_projection * vec4(rotated_pos + a_translation, 0., 1.0);
+   v_tex_coord= vec2(a_tex_coord.x + a_tex_dim.x * a_tex_pos.x, a_tex_coord.y - a_tex_dim.y * (1. - a_tex_pos.y));
+   v_color = a_color;
+   v_layer = a_layer;
+}
+)V0G0N";
+
 constexpr const char *vertex_sprite_code_direct = R"V0G0N(#version 300 es
 precision highp float;
 layout(location = 0) in vec2 a_position;
@@ -168,6 +301,20 @@ void main()
     FragColor =   v_color *  vec4(tex_color*tex_alpha, tex_alpha);
 }
 )V0G0N";
+constexpr const char *fragment_sprite_array_code = R"V0G0N(#version 300 es
+precision highp float;
+precision highp sampler2DArray;
+uniform sampler2DArray u_texture;
+in vec2 v_tex_coord;
+in vec4 v_color;
+flat in int v_layer;
+out vec4 FragColor;
+void main()
+{
+    vec4 tex_color = texture(u_texture, vec3(v_tex_coord, float(v_layer)));
+    FragColor =   v_color *  vec4(tex_color.rgb*tex_color.a, tex_color.a);
+}
+)V0G0N";
 constexpr const char *fragment_fullpass_texture_code_no_alpha = R"V0G0N(#version 300 es
                                                                 precision highp float;
                                                                 uniform sampler2D u_texture;
@@ -6,25 +6,48 @@
 #include "FrameBuffer.h"
 #include "Sprite.h"
 
+#include "../external/stbimage/stb_image.h"
+#include "../external/stbimage/stb_image_write.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H   //optional glyph management component (I keep these here because I'll probably need them )
 #include FT_OUTLINE_H //scalable outline management
+#ifdef RENDERER_USE_HARFBUZZ
+#include <hb.h>
+#include <hb-ft.h>
+#endif
 // #include FT_STROKER_H //functions to stroke outline paths
 
 Font::~Font()
 {
-    FT_Done_Face(*mp_face);
-    FT_Done_FreeType(*mp_ft);
+#ifdef RENDERER_USE_HARFBUZZ
+    hb_font_destroy(mp_hb_font);
+#endif
+    if (*mp_face)
+    {
+        FT_Done_Face(*mp_face);
+    }
+    if (*mp_ft)
+    {
+        FT_Done_FreeType(*mp_ft);
+    }
 }
 
 #include <chrono>
 
 //! \brief creates a font from a path to a file
-//! \param font_filename path to a font file
-Font::Font(std::filesystem::path font_filename, size_t font_pixel_size, FreetypeMode mode)
-    : m_mode(mode), m_font_pixel_size(font_pixel_size)
+//! \param font_filename path to a font file (or to a baked font, then size and mode are given by the file)
+//! \param usage   MetricsOnly fonts load only what is needed to measure texts and do not need a GL context
+Font::Font(std::filesystem::path font_filename, size_t font_pixel_size, FreetypeMode mode, FontUsage usage)
+    : m_mode(mode), m_font_pixel_size(font_pixel_size), m_usage(usage)
 {
     mp_face = std::make_unique<FT_Face>(FT_Face());
     mp_ft = std::make_unique<FT_Library>(FT_Library());
@@ -34,8 +57,8 @@ Font::Font(std::filesystem::path font_filename, size_t font_pixel_size, Freetype
         throw std::runtime_error("FONT FILE " + font_filename.string() + " NOT FOUND!");
     }
 }
-Font::Font(const unsigned char *bytes, std::size_t num_bytes, size_t font_pixel_size, FreetypeMode mode)
-    : m_mode(mode), m_font_pixel_size(font_pixel_size)
+Font::Font(const unsigned char *bytes, std::size_t num_bytes, size_t font_pixel_size, FreetypeMode mode, FontUsage usage)
+    : m_mode(mode), m_font_pixel_size(font_pixel_size), m_usage(usage)
 {
     mp_face = std::make_unique<FT_Face>(FT_Face());
     mp_ft = std::make_unique<FT_Library>(FT_Library());
@@ -75,178 +98,400 @@ float Font::getLineHeight() const
 
 bool Font::initializeFromFace(FT_Face &face)
 {
-    std::size_t font_texture_width = 2048; //! how to set this?
-    std::size_t font_texture_height = 2048;
-    std::size_t safety_margin = 2;         //! number of pixels that separate glyphs in texture
-    utils::Vector2<unsigned int> max_char_size = {0};
-    
-    //! create texture to draw into
-    TextureOptions options;
-    options.data_type = TextureDataTypes::UByte;
-    options.format = TextureFormat::RGBA;
-    options.internal_format = TextureFormat::RGBA;
-    options.mag_param = TexMappingParam::Linear;
-    options.min_param = TexMappingParam::Linear;
-    m_pixels = std::make_unique<FrameBuffer>(font_texture_width, font_texture_height, options);
-    m_canvas = std::make_unique<Renderer>(*m_pixels);
-    m_canvas->getShaders().loadFromCode("Font",
-                                        vertex_sprite_code,
-                                        fragment_font_code);
-
     FT_Set_Pixel_Sizes(face, 0, m_font_pixel_size);
     m_line_height = face->size->metrics.height / 64.f;
+#ifdef RENDERER_USE_HARFBUZZ
+    hb_font_destroy(mp_hb_font);
+    mp_hb_font = hb_ft_font_create_referenced(face); //! takes the scale from the face's current size
+#endif
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // disable byte-alignment restriction
-    glCheckError();
+    //! SDF scales well, so one rasterized size serves all font sizes up to the next power of two
+    m_raster_pixel_size = m_font_pixel_size;
+    if (m_mode == FreetypeMode::SDF && m_usage == FontUsage::Rendering)
+    {
+        m_raster_pixel_size = std::max(FONT_SDF_MIN_RASTER_SIZE, std::bit_ceil(m_font_pixel_size));
+    }
+    updateGlyphStyle();
 
-    std::size_t atlas_w = m_pixels->getSize().x;
-    std::size_t atlas_h = m_pixels->getSize().y;
-    // std::vector<uint8_t> atlas_pixels(atlas_w * atlas_h);
+    //! glyphs of the previous size stay in the cache, but the font's metrics changed
+    m_generation++;
+    m_characters.clear();
 
-    TextureOptions helper_texture_options = {
-        .format = TextureFormat::Red,
-        .internal_format = TextureFormat::R8,
-        .data_type = TextureDataTypes::UByte,
-        .mag_param = TexMappingParam::Linear,
-        .min_param = TexMappingParam::Linear,
-        .mipmap_levels = 0};
+    //! printable ASCII is used by almost every text, so it is rasterized right away
+    std::vector<int> codes;
+    for (int code = 32; code < 127; ++code)
+    {
+        if (FT_Get_Char_Index(face, code) != 0)
+        {
+            codes.push_back(code);
+        }
+    }
+    rasterizeGlyphs(codes);
+    uploadPendingGlyphs();
+    return true;
+}
 
-    Texture atlas_texture;
-    atlas_texture.create(atlas_w, atlas_h, helper_texture_options);
-    atlas_texture.bind();
+//! \brief finds the font's style in the GlyphCache, fonts with equal source, raster size and mode share glyphs
+void Font::updateGlyphStyle()
+{
+    m_glyph_scale = m_font_pixel_size / static_cast<float>(m_raster_pixel_size);
+    if (m_usage == FontUsage::MetricsOnly) //! the cache is not thread safe and metrics-only fonts do not need it
+    {
+        return;
+    }
+    m_glyph_style = GlyphCache::instance().getStyleId(m_source_name + "|" + std::to_string(m_raster_pixel_size) +
+                                                      "|" + std::to_string(static_cast<int>(m_mode)));
+}
 
-    auto &main_texture = m_pixels->getTexture();
-    m_canvas->m_view.setCenter(main_texture.getSize() / 2.f);
-    m_canvas->m_view.setSize(main_texture.getSize().x, -main_texture.getSize().y);
-    m_canvas->clear({1, 1, 1, 0});
-    m_canvas->m_blend_factors = {BlendFactor::One, BlendFactor::One};
+//! \returns glyph data of the character with \p code, rasterizes it if it was not used yet
+//!  Characters missing in the font get the glyph of the font's "missing glyph" (.notdef)
+//!  The pixels of a newly rasterized glyph reach the GPU only after uploadPendingGlyphs()
+const Character &Font::getCharacter(int code)
+{
+    if (m_usage == FontUsage::MetricsOnly)
+    {
+        {
+            std::shared_lock lock(m_metrics_mutex);
+            if (auto *character = m_characters.find(code))
+            {
+                return *character; //! records never move, so the reference stays valid after unlocking
+            }
+        }
+        auto lock = lockMetrics();
+        if (auto *character = m_characters.find(code)) //! another thread might have loaded it meanwhile
+        {
+            return *character;
+        }
+        return rasterizeGlyph(code);
+    }
 
-    auto tic = std::chrono::high_resolution_clock::now();
-    
-    //! initialize characters data
-    m_characters.clear();
-    utils::Vector2i glyph_pos = {0, 0};
-    
-    FT_UInt gindex;
-    FT_ULong charcode = FT_Get_First_Char(face, &gindex);
-    while (gindex != 0)
-    {
-        // load character glyph
-        if (FT_Load_Char(face, charcode, FT_LOAD_RENDER))
+    if (auto *character = m_characters.find(code))
+    {
+        return *character;
+    }
+    if (auto *cached_glyph = GlyphCache::instance().find(m_glyph_style, code))
+    {
+        return registerCharacter(code, *cached_glyph);
+    }
+    return rasterizeGlyph(code);
+}
+
+//! \returns index of the glyph of \p code in the charmap texture, rasterizes it if it was not used yet
+int Font::getTexCode(int code)
+{
+    return getCharacter(code).tex_code;
+}
+
+//! \brief rasterizes all \p characters which were not used yet and uploads them
+//!  Useful to avoid rasterization when the text first appears (e.g. in a loading screen)
+void Font::preload(const std::wstring &characters)
+{
+    auto lock = lockMetrics();
+    std::vector<int> codes;
+    for (int code : characters)
+    {
+        if (!m_characters.contains(code) && std::find(codes.begin(), codes.end(), code) == codes.end())
         {
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
+            codes.push_back(code);
+        }
+    }
+    rasterizeGlyphs(codes);
+    uploadPendingGlyphs();
+}
+
+//! \brief renders glyph of \p code with the \p face into a bitmap
+//!  Touches only the \p face, so it can run on any thread as long as each thread has its own face
+static GlyphBitmap rasterizeBitmap(FT_Face face, int code, FreetypeMode mode)
+{
+    GlyphBitmap result;
+    //! glyph index 0 is the missing glyph, negative codes hold glyph indices directly
+    FT_UInt glyph_index = code < 0 ? -(code + 1) : FT_Get_Char_Index(face, code);
+    if (FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT))
+    {
+        return result;
+    }
+
+    FT_GlyphSlot &glyph = face->glyph;
+    FT_BBox bbox;
+    FT_Outline_Get_CBox(&glyph->outline, &bbox);
+    FT_Render_Glyph(glyph, static_cast<FT_Render_Mode>(mode));
+    FT_Bitmap &bitmap = glyph->bitmap;
+
+    int width = bitmap.width;
+    int rows = bitmap.rows;
+    //! shaders sample alpha, so the coverage goes into all channels
+    //! rows are flipped so that the glyph's top row ends up at the top of its rect
+    result.pixels.resize(width * rows * 4);
+    for (int y = 0; y < rows; ++y)
+    {
+        int src_row = bitmap.pitch >= 0 ? y : rows - 1 - y;
+        const unsigned char *src = bitmap.buffer + src_row * std::abs(bitmap.pitch);
+        unsigned char *dst = result.pixels.data() + (rows - 1 - y) * width * 4;
+        for (int x = 0; x < width; ++x)
+        {
+            std::fill_n(dst + 4 * x, 4, src[x]);
+        }
+    }
+
+    float bb_width = (bbox.xMax / 64.f - bbox.xMin / 64.f);
+    float bb_height = (bbox.yMax / 64.f - bbox.yMin / 64.f);
+    result.loaded = true;
+    result.size = {width, rows};
+    result.bearing = {glyph->bitmap_left, glyph->bitmap_top};
+    result.bb = {bbox.xMin / 64.f, bbox.yMin / 64.f, bb_width, bb_height};
+    result.advance = glyph->advance.x;
+    return result;
+}
+
+//! \brief rasterizes glyph of \p code with FreeType and reserves space for it in the atlas
+Character &Font::rasterizeGlyph(int code)
+{
+    if (m_is_baked) //! there is nothing to rasterize with, so missing characters share the missing glyph
+    {
+        auto *missing_glyph = m_characters.find(0);
+        if (!missing_glyph && m_usage == FontUsage::MetricsOnly)
+        {
+            Character empty_glyph = {0, {0, 0}, {0, 0}, {0, 0}, {0, 0, 0, 0}, 0};
+            empty_glyph.tex_code = 0;
+            return registerCharacter(code, empty_glyph);
         }
+        if (!missing_glyph)
+        {
+            return packGlyph(code, {});
+        }
+        return m_characters.insert(code, *missing_glyph);
+    }
+    if (m_usage == FontUsage::MetricsOnly)
+    {
+        return registerCharacter(code, loadGlyphMetrics(code));
+    }
+    return packGlyph(code, rasterizeWithMainFace(code));
+}
+
+//! \brief loads metrics of the glyph of \p code without rendering it
+//!  bb and advance (everything measuring uses) are exact, size and bearing of the bitmap are estimated from the outline
+Character Font::loadGlyphMetrics(int code)
+{
+    constexpr int sdf_spread = 8; //! FreeType's default, SDF bitmaps are larger than the outline by that on each side
+
+    Character character = {0, {0, 0}, {0, 0}, {0, 0}, {0, 0, 0, 0}, 0};
+    character.tex_code = 0; //! marks the record as used in the GlyphTable
+    FT_Face &face = *mp_face;
+    FT_UInt glyph_index = code < 0 ? -(code + 1) : FT_Get_Char_Index(face, code);
+    if (FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT))
+    {
+        std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+        return character;
+    }
+
+    FT_BBox bbox;
+    FT_Outline_Get_CBox(&face->glyph->outline, &bbox);
+    int left = static_cast<int>(std::floor(bbox.xMin / 64.f));
+    int right = static_cast<int>(std::ceil(bbox.xMax / 64.f));
+    int bottom = static_cast<int>(std::floor(bbox.yMin / 64.f));
+    int top = static_cast<int>(std::ceil(bbox.yMax / 64.f));
+    int spread = m_mode == FreetypeMode::SDF && right > left ? sdf_spread : 0;
+
+    character.size = {right - left + 2 * spread, top - bottom + 2 * spread};
+    character.bearing = {left - spread, top + spread};
+    character.bb = {bbox.xMin / 64.f, bbox.yMin / 64.f, (bbox.xMax - bbox.xMin) / 64.f, (bbox.yMax - bbox.yMin) / 64.f};
+    character.advance = face->glyph->advance.x;
+    return character;
+}
+
+//! \returns lock of the font's metrics for metrics-only fonts, fonts for rendering are used by the GL thread only
+std::unique_lock<std::shared_mutex> Font::lockMetrics() const
+{
+    if (m_usage == FontUsage::MetricsOnly)
+    {
+        return std::unique_lock(m_metrics_mutex);
+    }
+    return {};
+}
+
+//! \brief rasterizes glyph of \p code with the font's own face at the raster size
+//!  the face is set back to the font size afterwards, because kerning and shaping read it
+GlyphBitmap Font::rasterizeWithMainFace(int code)
+{
+    if (m_raster_pixel_size == m_font_pixel_size)
+    {
+        return rasterizeBitmap(*mp_face, code, m_mode);
+    }
+    FT_Set_Pixel_Sizes(*mp_face, 0, m_raster_pixel_size);
+    auto bitmap = rasterizeBitmap(*mp_face, code, m_mode);
+    FT_Set_Pixel_Sizes(*mp_face, 0, m_font_pixel_size);
+    return bitmap;
+}
+
+//! \brief rasterizes glyphs of all \p codes, the work is split between worker threads
+//!  Glyphs already in the GlyphCache (rasterized by another font of the same style) are just registered.
+//!  Each worker opens its own FT_Library and FT_Face, because FreeType objects must not be shared between threads.
+//!  The bitmaps are packed into the atlas on the calling (GL) thread afterwards, in the order of \p codes
+void Font::rasterizeGlyphs(const std::vector<int> &requested_codes)
+{
+    constexpr std::size_t min_glyphs_per_worker = 32; //! opening a face costs about as much as rendering a few glyphs
+
+    if (m_usage == FontUsage::MetricsOnly) //! loading metrics is cheap, there is nothing to parallelize
+    {
+        for (auto code : requested_codes)
+        {
+            rasterizeGlyph(code);
+        }
+        return;
+    }
+
+    std::vector<int> codes;
+    for (auto code : requested_codes)
+    {
+        if (auto *cached_glyph = GlyphCache::instance().find(m_glyph_style, code))
+        {
+            registerCharacter(code, *cached_glyph);
+        }
+        else
+        {
+            codes.push_back(code);
+        }
+    }
+    std::vector<GlyphBitmap> bitmaps(codes.size());
 
-        FT_GlyphSlot &glyph = face->glyph;
-        FT_Bitmap &bitmap = glyph->bitmap;
-        FT_Render_Glyph(glyph, static_cast<FT_Render_Mode>(m_mode));
+    if (m_is_baked)
+    {
+        for (auto code : codes)
+        {
+            rasterizeGlyph(code);
+        }
+        return;
+    }
 
-        if (glyph_pos.x + bitmap.width + safety_margin >= main_texture.getSize().x) //! if we reach right side of the main texture
+    std::size_t workers_count = 1;
+#ifndef __EMSCRIPTEN__ //! no threads without -pthread in the browser
+    workers_count = std::clamp<std::size_t>(codes.size() / min_glyphs_per_worker, 1, std::max(1u, std::thread::hardware_concurrency()));
+#endif
+    if (workers_count == 1)
+    {
+        for (std::size_t i = 0; i < codes.size(); ++i)
+        {
+            bitmaps[i] = rasterizeWithMainFace(codes[i]);
+        }
+    }
+    else
+    {
+        std::size_t shard_size = (codes.size() + workers_count - 1) / workers_count;
+        std::vector<char> shard_done(workers_count, false);
+        std::vector<std::thread> workers;
+        for (std::size_t worker_id = 0; worker_id < workers_count; ++worker_id)
         {
-            glyph_pos.y += max_char_size.y + safety_margin;
-            glyph_pos.x = 0;
-            max_char_size = {0};
+            workers.emplace_back([&, worker_id]()
+                                 {
+                FT_Library library;
+                FT_Face face;
+                if (FT_Init_FreeType(&library))
+                {
+                    return;
+                }
+                if (openFace(library, face))
+                {
+                    FT_Set_Pixel_Sizes(face, 0, m_raster_pixel_size);
+                    std::size_t end = std::min(codes.size(), (worker_id + 1) * shard_size);
+                    for (std::size_t i = worker_id * shard_size; i < end; ++i)
+                    {
+                        bitmaps[i] = rasterizeBitmap(face, codes[i], m_mode);
+                    }
+                    shard_done[worker_id] = true;
+                    FT_Done_Face(face);
+                }
+                FT_Done_FreeType(library); });
         }
-        max_char_size = {std::max(bitmap.width, max_char_size.x), std::max(bitmap.rows, max_char_size.y)};
-
-         glTexSubImage2D(GL_TEXTURE_2D, 0,
-                        glyph_pos.x, glyph_pos.y,
-                        bitmap.width, bitmap.rows,
-                        GL_RED, GL_UNSIGNED_BYTE, bitmap.buffer) ;
-        glCheckError(); //! the error here is most likely due to rendering outside of texture
-
-        FT_BBox bbox;
-        FT_Outline_Get_CBox(&glyph->outline, &bbox);
-
-        float width = (bbox.xMax / 64.f - bbox.xMin / 64.f);
-        float height = (bbox.yMax / 64.f - bbox.yMin / 64.f);
-        Rectf char_bb = {bbox.xMin / 64.f, bbox.yMin / 64.f, width, height};
-
-        // for (int y = 0; y < bitmap.rows; ++y)
-        // {
-        //     int dest_y = glyph_pos.y + y;
-        //     int dest_x = glyph_pos.x;
-        //     memcpy(&atlas_pixels[dest_y * atlas_w + dest_x],
-        //            bitmap.buffer + y * bitmap.pitch,
-        //            bitmap.width);
-        // }
-
-        Character character =
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        //! a worker which could not open the face leaves its shard to the main face
+        for (std::size_t worker_id = 0; worker_id < workers_count; ++worker_id)
+        {
+            std::size_t end = std::min(codes.size(), (worker_id + 1) * shard_size);
+            for (std::size_t i = worker_id * shard_size; i < end && !shard_done[worker_id]; ++i)
             {
-                main_texture.getHandle(),
-                glyph_pos,
-                {bitmap.width, bitmap.rows},
-                {glyph->bitmap_left, glyph->bitmap_top},
-                char_bb,
-                (unsigned int)glyph->advance.x};
-        m_characters.insert(std::pair<int, Character>(charcode, character));
+                bitmaps[i] = rasterizeWithMainFace(codes[i]);
+            }
+        }
+    }
 
-        glyph_pos.x += bitmap.width + safety_margin; //! move position to next glyph
+    for (std::size_t i = 0; i < codes.size(); ++i)
+    {
+        packGlyph(codes[i], std::move(bitmaps[i]));
+    }
+}
 
-        charcode = FT_Get_Next_Char(face, charcode, &gindex);
+//! \brief opens a new face of the font's source in the \p library
+//! \returns true on success
+bool Font::openFace(FT_Library library, FT_Face &face) const
+{
+    if (mp_font_bytes)
+    {
+        return !FT_New_Memory_Face(library, mp_font_bytes, m_font_bytes_count, 0, &face);
     }
-    auto toc = std::chrono::high_resolution_clock::now();
-    std::cout << "font render: " << std::chrono::duration_cast<std::chrono::milliseconds>(toc - tic) << std::endl;
-    // GLuint tex;
-    // glGenTextures(1, &tex);
-    // glBindTexture(GL_TEXTURE_2D, tex);
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas_w, atlas_h, 0, GL_RED, GL_UNSIGNED_BYTE, atlas_pixels.data());
-
-    Sprite glyph_sprite(main_texture);
-    glyph_sprite.m_texture_handles[0] =  atlas_texture.getHandle(); //tex
-    glyph_sprite.setPosition(main_texture.getSize() / 2.f);
-    glyph_sprite.setScale(main_texture.getSize() / 2.f);
-    glCheckError();
-    m_canvas->drawSprite(glyph_sprite, "Font");
-
-    using bf = BlendFactor;
-    m_canvas->m_blend_factors = {bf::One, bf::Zero, bf::One, bf::Zero};
-    m_canvas->drawAll();
-    m_canvas->resetBatches();
-    // writeTextureToFile("../", "pica.png", *m_pixels);
-    //! delete helper texture
-    // glDeleteTextures(1, &tex);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4); //! set back to deafult value
-
-    renderCharMapTexture();
-    return true;
+    return !FT_New_Face(library, m_font_file.string().c_str(), 0, &face);
+}
+
+//! \brief puts the \p bitmap into the GlyphCache and registers it as the glyph of \p code
+Character &Font::packGlyph(int code, GlyphBitmap bitmap)
+{
+    if (!bitmap.loaded && !m_is_baked)
+    {
+        std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+    }
+    return registerCharacter(code, GlyphCache::instance().insert(m_glyph_style, code, std::move(bitmap)));
 }
 
-//! \brief renders glyph information into texture which will be read from gpu by shader
-void Font::renderCharMapTexture()
+//! \brief stores the \p cached_glyph in the font's table, its metrics are scaled from the raster size to the font size
+//!  the rect in the atlas (tex_coords, tex_size and tex_code) stays the same
+Character &Font::registerCharacter(int code, const Character &cached_glyph)
 {
-    int char_count = m_characters.size();
-    std::vector<Rectf> glyph_tex_rects(char_count);
+    Character character = cached_glyph;
+    if (m_glyph_scale != 1.f)
+    {
+        auto scaled = [this](int distance)
+        { return static_cast<int>(std::lround(distance * m_glyph_scale)); };
+        character.size = {scaled(cached_glyph.size.x), scaled(cached_glyph.size.y)};
+        character.bearing = {scaled(cached_glyph.bearing.x), scaled(cached_glyph.bearing.y)};
+        character.bb = {cached_glyph.bb.pos_x * m_glyph_scale, cached_glyph.bb.pos_y * m_glyph_scale,
+                        cached_glyph.bb.width * m_glyph_scale, cached_glyph.bb.height * m_glyph_scale};
+        character.advance = static_cast<unsigned int>(std::lround(cached_glyph.advance * m_glyph_scale));
+    }
+    return m_characters.insert(code, character);
+}
 
-    utils::Vector2f atlas_size = m_pixels->getSize();
-    int tex_code = 0;
-    for (auto &[code, character] : m_characters)
+//! \brief sends all glyphs rasterized since the last call to the GPU (glyphs of all fonts share the upload)
+void Font::uploadPendingGlyphs()
+{
+    if (m_usage == FontUsage::Rendering)
     {
-        m_charcode2texcode[code] = tex_code;
-        utils::Vector2f texrect_coords = {character.tex_coords.x / atlas_size.x, 1.f - character.tex_coords.y / atlas_size.y};
-        utils::Vector2f texrect_size = {character.size.x / atlas_size.x, character.size.y / atlas_size.y};
-        glyph_tex_rects.at(tex_code) = {texrect_coords.x, texrect_coords.y, texrect_size.x, texrect_size.y};
-        tex_code++;
+        GlyphCache::instance().uploadPendingGlyphs();
     }
+}
 
-    glGenTextures(1, &m_charmap_tex_id);
-    glBindTexture(GL_TEXTURE_2D, m_charmap_tex_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, char_count, 1, 0, GL_RGBA, GL_FLOAT, glyph_tex_rects.data());
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+//! \returns number of atlas pages in the GlyphCache, all fonts share them
+std::size_t Font::getPagesCount() const
+{
+    return GlyphCache::instance().getPagesCount();
+}
+
+//! \returns page of the atlas with index \p page_index, glyphs refer to their page by Character::texture_id
+Texture &Font::getPage(std::size_t page_index)
+{
+    return GlyphCache::instance().getPage(page_index);
 }
 
+//! \returns charmap texture of the GlyphCache, all fonts share it, so their texts can be batched together
 GLuint Font::getCharmapTexId() const
 {
-    return m_charmap_tex_id;
+    return GlyphCache::instance().getCharmapTexId();
 }
 
-//! \brief loads font from the specified file
+//! \brief loads font from bytes in memory (e.g. an entry of a mapped AssetPack)
+//! \brief FreeType reads from \p bytes lazily, so they must outlive the font
 //! \return true if font was succesfully loaded
 bool Font::loadFromBytes(const unsigned char *bytes, std::size_t num_bytes)
 {
@@ -255,7 +500,12 @@ bool Font::loadFromBytes(const unsigned char *bytes, std::size_t num_bytes)
         return false;
     }
 
-    if (FT_New_Memory_Face(*mp_ft, bytes, num_bytes, 0, mp_face.get()))
+    mp_font_bytes = bytes;
+    m_font_bytes_count = num_bytes;
+    std::ostringstream source_name;
+    source_name << "memory:" << static_cast<const void *>(bytes) << ":" << num_bytes;
+    m_source_name = source_name.str();
+    if (!openFace(*mp_ft, *mp_face))
     {
         return false;
     }
@@ -268,12 +518,18 @@ bool Font::loadFromBytes(const unsigned char *bytes, std::size_t num_bytes)
 //! \return true if font was succesfully loaded
 bool Font::loadFromFile(std::filesystem::path font_file)
 {
+    if (font_file.extension() == BAKED_FONT_EXTENSION)
+    {
+        return loadFromBaked(font_file);
+    }
+
     if (FT_Init_FreeType(mp_ft.get()))
     {
         // spdlog::error("FREETYPE: Could not init FreeType Library");
         return false;
     }
 
+    m_source_name = font_file.string();
 #if defined(__ANDROID__)
     SDL_RWops *rw = SDL_RWFromFile(font_file.c_str(), "rb");
     // On Android this reads from assets.
@@ -283,37 +539,43 @@ bool Font::loadFromFile(std::filesystem::path font_file)
         SDL_Log("Could not open font: %s", SDL_GetError());
     }
 
-    // Read file into memory
+    // Read file into memory, it is kept because worker threads open their own faces from it
     Sint64 size = SDL_RWsize(rw);
-    std::vector<unsigned char> buffer(size);
-    SDL_RWread(rw, buffer.data(), 1, size);
+    m_font_buffer.resize(size);
+    SDL_RWread(rw, m_font_buffer.data(), 1, size);
     SDL_RWclose(rw);
-    if (FT_New_Memory_Face(m_ft, buffer.data(), buffer.size(), 0, &m_face))
-    {
-        return false;
-    }
+    mp_font_bytes = m_font_buffer.data();
+    m_font_bytes_count = m_font_buffer.size();
 #else
-    if (FT_New_Face(*mp_ft, font_file.string().c_str(), 0, mp_face.get()))
+    m_font_file = font_file;
+#endif
+    if (!openFace(*mp_ft, *mp_face))
     {
         return false;
     }
-#endif
 
     bool init_face_success = initializeFromFace(*mp_face);
 
     return init_face_success;
 }
 
-//! \return a texture containing character SDFs
+//! \return first page of the atlas containing character SDFs (all pending glyphs are uploaded)
 Texture &Font::getTexture()
 {
-    return m_pixels->getTexture();
+    uploadPendingGlyphs();
+    return getPage(0);
 }
 
 std::size_t Font::getFontPixelSize() const
 {
     return m_font_pixel_size;
 }
+
+//! \returns size at which the glyphs are rasterized, it is larger than the font size for SDF fonts
+std::size_t Font::getRasterPixelSize() const
+{
+    return m_raster_pixel_size;
+}
 FreetypeMode Font::getMode() const
 {
     return m_mode;
@@ -321,92 +583,386 @@ FreetypeMode Font::getMode() const
 
 void Font::setFontPixelSize(std::size_t font_pixel_size)
 {
+    if (m_is_baked)
+    {
+        std::cout << "Baked font can not change its size!" << std::endl;
+        return;
+    }
     m_font_pixel_size = font_pixel_size;
     initializeFromFace(*mp_face);
 }
+constexpr char baked_font_magic[4] = {'R', 'F', 'N', 'T'};
+constexpr std::uint32_t baked_font_version = 2;
+
 template <class T>
-std::istream &operator>>(std::istream &data, utils::Vector2<T> &vec)
+static void writeValue(std::ostream &data, const T &value)
 {
-    return data >> vec.x >> vec.y;
+    data.write(reinterpret_cast<const char *>(&value), sizeof(T));
 }
+
 template <class T>
-std::istream &operator>>(std::istream &data, Rect<T> &rect)
+static bool readValue(std::istream &data, T &value)
 {
-    return data >> rect.pos_x >> rect.pos_y >> rect.width >> rect.height;
-}
-std::istream &operator>>(std::istream &data, Character &c)
-{
-    return data >> c.advance >> c.bb >> c.bearing >> c.size >> c.tex_coords;
+    data.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<bool>(data);
 }
 
-template <class T>
-std::ostream &operator<<(std::ostream &data, const utils::Vector2<T> &vec)
+static void writeCharacter(std::ostream &data, int code, std::uint32_t page_index, const Character &c)
 {
-    return data << vec.x << vec.y;
+    writeValue(data, std::int32_t(code));
+    writeValue(data, page_index);
+    writeValue(data, std::int32_t(c.tex_coords.x));
+    writeValue(data, std::int32_t(c.tex_coords.y));
+    writeValue(data, std::int32_t(c.size.x));
+    writeValue(data, std::int32_t(c.size.y));
+    writeValue(data, std::int32_t(c.bearing.x));
+    writeValue(data, std::int32_t(c.bearing.y));
+    writeValue(data, c.bb.pos_x);
+    writeValue(data, c.bb.pos_y);
+    writeValue(data, c.bb.width);
+    writeValue(data, c.bb.height);
+    writeValue(data, std::uint32_t(c.advance));
 }
 
-template <class T>
-std::ostream &operator<<(std::ostream &data, const Rect<T> &rect)
+static bool readCharacter(std::istream &data, std::int32_t &code, std::uint32_t &page_index, Character &c)
 {
-    return data << rect.pos_x << rect.pos_y << rect.width << rect.height;
+    std::int32_t tex_x, tex_y, size_x, size_y, bearing_x, bearing_y;
+    std::uint32_t advance;
+    bool success = readValue(data, code) && readValue(data, page_index) &&
+                   readValue(data, tex_x) && readValue(data, tex_y) &&
+                   readValue(data, size_x) && readValue(data, size_y) &&
+                   readValue(data, bearing_x) && readValue(data, bearing_y) &&
+                   readValue(data, c.bb.pos_x) && readValue(data, c.bb.pos_y) &&
+                   readValue(data, c.bb.width) && readValue(data, c.bb.height) &&
+                   readValue(data, advance);
+    c.tex_coords = {tex_x, tex_y};
+    c.size = {size_x, size_y};
+    c.bearing = {bearing_x, bearing_y};
+    c.advance = advance;
+    return success;
 }
 
-std::ostream &operator<<(std::ostream &data, const Character &c)
+static std::filesystem::path bakedPagePath(const std::filesystem::path &metadata_path, std::size_t page_index)
 {
-    return data << c.advance << c.bb << c.bearing << c.size << c.tex_coords;
+    auto page_path = metadata_path;
+    page_path.replace_filename(metadata_path.stem().string() + "_" + std::to_string(page_index) + ".png");
+    return page_path;
 }
 
-std::unordered_map<char, Character> deserializeCharacters(const std::filesystem::path &file_path)
+//! \brief reads whole file at \p path (from assets on Android)
+static std::string readBakedFile(const std::filesystem::path &path)
 {
-    if (!std::filesystem::exists(file_path))
+#ifdef __ANDROID__
+    SDL_RWops *rw = SDL_RWFromFile(path.string().c_str(), "rb");
+    if (!rw)
     {
-        std::cout << "Warning file: " << file_path << "does not exist!" << std::endl;
         return {};
     }
+    std::string contents(SDL_RWsize(rw), '\0');
+    SDL_RWread(rw, contents.data(), 1, contents.size());
+    SDL_RWclose(rw);
+    return contents;
+#else
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+#endif
+}
 
-    std::ifstream data_file(file_path);
-    std::unordered_map<char, Character> characters;
+static std::uint64_t kerningKey(int left_code, int right_code)
+{
+    return (std::uint64_t(std::uint32_t(left_code)) << 32) | std::uint32_t(right_code);
+}
 
-    int char_count = 0;
-    data_file >> char_count;
-    char code;
-    Character character;
-    while (data_file)
+//! \returns kerning between characters \p left_code and \p right_code in 1/64 of pixel (same units as Character::advance)
+int Font::getKerning(int left_code, int right_code)
+{
+    if (m_is_baked)
     {
-        data_file >> code;
-        data_file >> character;
-        characters.insert({code, character});
+        auto it = m_kerning.find(kerningKey(left_code, right_code));
+        return it == m_kerning.end() ? 0 : it->second;
     }
 
-    return characters;
+    FT_Face &face = *mp_face;
+    if (!FT_HAS_KERNING(face))
+    {
+        return 0;
+    }
+    auto lock = lockMetrics();
+    FT_Vector delta;
+    if (FT_Get_Kerning(face, FT_Get_Char_Index(face, left_code), FT_Get_Char_Index(face, right_code), FT_KERNING_DEFAULT, &delta))
+    {
+        return 0;
+    }
+    return delta.x;
 }
-void serializeCharacters(std::ostream &data_file,
-                         const std::unordered_map<int, Character> &characters)
+
+//! \brief positions glyphs of the \p text
+//!  With HarfBuzz the text is fully shaped (kerning, ligatures, complex scripts), the glyphs are then keyed
+//!  by glyphIndexKey(). Otherwise (and always for baked fonts) each character gets its own glyph and the
+//!  advances include kerning from the font's kerning table.
+std::vector<ShapedGlyph> Font::shape(const std::wstring &text)
 {
+    std::vector<ShapedGlyph> glyphs;
+    glyphs.reserve(text.size());
+#ifdef RENDERER_USE_HARFBUZZ
+    if (mp_hb_font && !m_is_baked)
+    {
+        auto lock = lockMetrics(); //! HarfBuzz reads the FreeType face
+        hb_buffer_t *buffer = hb_buffer_create();
+        std::vector<std::uint32_t> codepoints(text.begin(), text.end());
+        hb_buffer_add_utf32(buffer, codepoints.data(), codepoints.size(), 0, codepoints.size());
+        hb_buffer_guess_segment_properties(buffer);
+        hb_shape(mp_hb_font, buffer, nullptr, 0);
+
+        unsigned int glyphs_count = 0;
+        hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &glyphs_count);
+        hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, &glyphs_count);
+        for (unsigned int i = 0; i < glyphs_count; ++i)
+        {
+            //! positions are in 26.6 like everything else coming from FreeType
+            glyphs.push_back({glyphIndexKey(infos[i].codepoint), infos[i].cluster,
+                              positions[i].x_advance / 64.f, positions[i].x_offset / 64.f, positions[i].y_offset / 64.f});
+        }
+        hb_buffer_destroy(buffer);
+        return glyphs;
+    }
+#endif
 
-    data_file << characters.size();
-    for (auto [code, data] : characters)
+    for (std::size_t i = 0; i < text.size(); ++i)
     {
-        data_file << code << data;
+        int advance = getCharacter(text[i]).advance;
+        if (i + 1 < text.size())
+        {
+            advance += getKerning(text[i], text[i + 1]);
+        }
+        glyphs.push_back({static_cast<int>(text[i]), i, advance / 64.f});
     }
+    return glyphs;
+}
+
+bool Font::isBaked() const
+{
+    return m_is_baked;
 }
 
-void writeToFIle(const Font &font, const std::filesystem::path &path)
+FontUsage Font::getUsage() const
 {
-    std::ofstream data_file(path);
-    data_file << font.getFontPixelSize() << static_cast<int>(font.getMode());
-    serializeCharacters(data_file, font.m_characters);
+    return m_usage;
+}
+
+//! \returns number which changes whenever glyphs of the font are thrown away (e.g. by setFontPixelSize())
+//!  layouts computed with a different generation are no longer valid
+std::size_t Font::getGeneration() const
+{
+    return m_generation;
+}
+
+//! \brief bakes all rasterized glyphs into \p directory as <font_name>.font (glyph table) and <font_name>_<page>.png
+//!  Only glyphs rasterized so far are baked, use preload() to choose them.
+//!  Atlas pages are shared by all fonts, so the PNGs may contain glyphs of other fonts too
+//! \returns true if all files were written
+bool Font::saveToFile(const std::filesystem::path &directory, const std::string &font_name)
+{
+    if (m_usage == FontUsage::MetricsOnly)
+    {
+        std::cout << "Metrics-only font has no glyphs to bake!" << std::endl;
+        return false;
+    }
+    getCharacter(0); //! the missing glyph replaces characters which were not baked
+    uploadPendingGlyphs();
+
+    auto metadata_path = directory / (font_name + BAKED_FONT_EXTENSION);
+    std::ofstream data(metadata_path, std::ios::binary);
+    if (!data)
+    {
+        std::cout << "Could not open file: " << metadata_path << std::endl;
+        return false;
+    }
+
+    //! glyphs are stored as they are in the cache (in raster size), only pages containing them are written
+    auto &cache = GlyphCache::instance();
+    std::vector<std::pair<int, const Character *>> glyphs;
+    std::vector<std::size_t> page_indices; //! indices of written pages in the cache
+    m_characters.forEach([&](int code, const Character &)
+                         {
+        auto *cached_glyph = cache.find(m_glyph_style, code);
+        if (!cached_glyph) //! characters sharing the missing glyph are not baked
+        {
+            return;
+        }
+        glyphs.push_back({code, cached_glyph});
+        auto page_index = cache.getPageIndex(cached_glyph->texture_id);
+        if (std::find(page_indices.begin(), page_indices.end(), page_index) == page_indices.end())
+        {
+            page_indices.push_back(page_index);
+        } });
+
+    std::vector<std::pair<int, int>> kerning_pairs;
+    for (auto [left_code, left_glyph] : glyphs)
+    {
+        for (auto [right_code, right_glyph] : glyphs)
+        {
+            if (left_code != 0 && right_code != 0 && getKerning(left_code, right_code) != 0)
+            {
+                kerning_pairs.push_back({left_code, right_code});
+            }
+        }
+    }
+
+    data.write(baked_font_magic, sizeof(baked_font_magic));
+    writeValue(data, baked_font_version);
+    writeValue(data, std::uint32_t(m_font_pixel_size));
+    writeValue(data, std::uint32_t(m_raster_pixel_size));
+    writeValue(data, std::int32_t(m_mode));
+    writeValue(data, m_line_height);
+    writeValue(data, std::int32_t(FONT_ATLAS_PAGE_SIZE));
+    writeValue(data, std::uint32_t(page_indices.size()));
+    writeValue(data, std::uint32_t(glyphs.size()));
+    writeValue(data, std::uint32_t(kerning_pairs.size()));
+
+    for (auto [code, cached_glyph] : glyphs)
+    {
+        auto page_it = std::find(page_indices.begin(), page_indices.end(), cache.getPageIndex(cached_glyph->texture_id));
+        writeCharacter(data, code, std::distance(page_indices.begin(), page_it), *cached_glyph);
+    }
+    for (auto [left_code, right_code] : kerning_pairs)
+    {
+        writeValue(data, std::int32_t(left_code));
+        writeValue(data, std::int32_t(right_code));
+        writeValue(data, std::int32_t(getKerning(left_code, right_code)));
+    }
+    if (!data)
+    {
+        std::cout << "Could not write file: " << metadata_path << std::endl;
+        return false;
+    }
+
+    //! PNGs are stored top row first, but GL gives us the bottom row first
+    stbi_flip_vertically_on_write(true);
+    bool pages_written = true;
+    for (std::size_t page_ind = 0; page_ind < page_indices.size(); ++page_ind)
+    {
+        auto page_path = bakedPagePath(metadata_path, page_ind);
+        LDRImage image(cache.getPage(page_indices[page_ind]));
+        pages_written &= stbi_write_png(page_path.string().c_str(), FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE,
+                                        4, image.data(), 4 * FONT_ATLAS_PAGE_SIZE) != 0;
+    }
+    stbi_flip_vertically_on_write(false);
+    return pages_written;
 }
 
-bool Font::loadFromImage(const std::filesystem::path &image_path, const std::filesystem::path &metadata_path)
+//! \brief loads font baked by saveToFile(), the atlas pages are expected next to the \p metadata_path
+//!  glyphs are copied from the pages into the GlyphCache, so baked fonts are batched together with the others
+//! \return true if font was succesfully loaded
+bool Font::loadFromBaked(const std::filesystem::path &metadata_path)
 {
-    deserializeCharacters(metadata_path);
-    return false;
+    std::istringstream data(readBakedFile(metadata_path));
+
+    char magic[4] = {};
+    std::uint32_t version, pixel_size, raster_pixel_size, pages_count, glyphs_count, kerning_count;
+    std::int32_t mode, page_size;
+    data.read(magic, sizeof(magic));
+    if (!data || !std::equal(magic, magic + 4, baked_font_magic) ||
+        !readValue(data, version) || version != baked_font_version)
+    {
+        std::cout << "File: " << metadata_path << " is not a baked font!" << std::endl;
+        return false;
+    }
+    if (!readValue(data, pixel_size) || !readValue(data, raster_pixel_size) || !readValue(data, mode) ||
+        !readValue(data, m_line_height) || !readValue(data, page_size) || !readValue(data, pages_count) ||
+        !readValue(data, glyphs_count) || !readValue(data, kerning_count) ||
+        page_size != FONT_ATLAS_PAGE_SIZE || raster_pixel_size == 0)
+    {
+        std::cout << "Baked font: " << metadata_path << " has a wrong header!" << std::endl;
+        return false;
+    }
+
+    m_is_baked = true;
+    m_generation++;
+    m_font_pixel_size = pixel_size;
+    m_raster_pixel_size = raster_pixel_size;
+    m_mode = static_cast<FreetypeMode>(mode);
+    m_source_name = "baked:" + metadata_path.string();
+    updateGlyphStyle();
+    m_characters.clear();
+    m_kerning.clear();
+
+    //! pages are decoded on the CPU only, glyphs are cut out of them
+    struct PageImage
+    {
+        unsigned char *pixels = nullptr; //!< RGBA, top row first
+        ~PageImage() { stbi_image_free(pixels); }
+    };
+    std::vector<PageImage> pages(m_usage == FontUsage::Rendering ? pages_count : 0); //! metrics need no pixels
+    stbi_set_flip_vertically_on_load(false);
+    for (std::size_t page_index = 0; page_index < pages.size(); ++page_index)
+    {
+        auto encoded_page = readBakedFile(bakedPagePath(metadata_path, page_index));
+        int width, height, channels_count;
+        pages[page_index].pixels = stbi_load_from_memory(reinterpret_cast<const unsigned char *>(encoded_page.data()),
+                                                         encoded_page.size(), &width, &height, &channels_count, 4);
+        if (!pages[page_index].pixels || width != FONT_ATLAS_PAGE_SIZE || height != FONT_ATLAS_PAGE_SIZE)
+        {
+            std::cout << "Could not load page " << page_index << " of a baked font: " << metadata_path << std::endl;
+            return false;
+        }
+    }
+
+    for (std::uint32_t i = 0; i < glyphs_count; ++i)
+    {
+        std::int32_t code;
+        std::uint32_t page_index;
+        Character character;
+        if (!readCharacter(data, code, page_index, character) || page_index >= pages_count ||
+            character.size.x < 0 || character.size.y < 0 || character.tex_coords.x < 0 || character.tex_coords.y < 0 ||
+            character.tex_coords.x + character.size.x > FONT_ATLAS_PAGE_SIZE ||
+            character.tex_coords.y + character.size.y > FONT_ATLAS_PAGE_SIZE)
+        {
+            std::cout << "Baked font: " << metadata_path << " is corrupted!" << std::endl;
+            return false;
+        }
+        if (m_usage == FontUsage::MetricsOnly)
+        {
+            character.tex_code = 0; //! marks the record as used in the GlyphTable
+            registerCharacter(code, character);
+            continue;
+        }
+        if (auto *cached_glyph = GlyphCache::instance().find(m_glyph_style, code)) //! the font was loaded before
+        {
+            registerCharacter(code, *cached_glyph);
+            continue;
+        }
+
+        GlyphBitmap bitmap = {true, character.size, character.bearing, character.bb, character.advance, {}};
+        bitmap.pixels.resize(character.size.x * character.size.y * 4);
+        for (int row = 0; row < character.size.y; ++row) //! bitmap rows go bottom to top
+        {
+            const unsigned char *src = pages[page_index].pixels +
+                                       4 * ((character.tex_coords.y + character.size.y - 1 - row) * FONT_ATLAS_PAGE_SIZE + character.tex_coords.x);
+            std::copy_n(src, 4 * character.size.x, bitmap.pixels.data() + 4 * row * character.size.x);
+        }
+        packGlyph(code, std::move(bitmap));
+    }
+    for (std::uint32_t i = 0; i < kerning_count; ++i)
+    {
+        std::int32_t left_code, right_code, kerning;
+        if (!readValue(data, left_code) || !readValue(data, right_code) || !readValue(data, kerning))
+        {
+            std::cout << "Baked font: " << metadata_path << " is corrupted!" << std::endl;
+            return false;
+        }
+        m_kerning[kerningKey(left_code, right_code)] = kerning;
+    }
+
+    uploadPendingGlyphs();
+    return true;
 }
 
+//! \returns true if the font has a glyph for \p code (it does not have to be rasterized yet)
 bool Font::containsUTF8Code(unsigned int code) const
 {
-    return m_characters.contains(code);
+    auto lock = lockMetrics();
+    return m_characters.contains(code) || (!m_is_baked && FT_Get_Char_Index(*mp_face, code) != 0);
 }
 
 //! prerendered font just in case i need it....
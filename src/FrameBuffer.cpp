@@ -18,8 +18,20 @@ FrameBuffer::~FrameBuffer()
     glDeleteFramebuffers(1, &m_target_handle);
 }
 
+//! \brief Eager mipmaps would be computed from an empty texture, so they are made Lazy instead
+static TextureOptions renderTargetOptions(TextureOptions options)
+{
+    if (options.mipmap_generation == MipmapGeneration::Eager)
+    {
+        options.mipmap_generation = MipmapGeneration::Lazy;
+    }
+    return options;
+}
+
+//! \brief construct by specifying the buffer \p width and \p height and \p options of its texture
+//!  drawing into the buffer changes the texture, so its mipmaps are never generated Eagerly (see MipmapGeneration)
 FrameBuffer::FrameBuffer(int width, int height, TextureOptions options)
-    : RenderTarget(width, height), m_options(options)
+    : RenderTarget(width, height), m_options(renderTargetOptions(options))
 {
     glGenFramebuffers(1, &m_target_handle);
     glBindFramebuffer(GL_FRAMEBUFFER, m_target_handle);
@@ -69,6 +81,16 @@ GLuint FrameBuffer::getHandle() const
 }
 
 
+//! \brief binds the buffer for drawing, so mipmaps of its texture become outdated
+void FrameBuffer::bind()
+{
+    RenderTarget::bind();
+    if (m_texture)
+    {
+        m_texture->markMipmapsDirty();
+    }
+}
+
 void FrameBuffer::resize(int w, int h)
 {
     if(w == 0 || h == 0)
@@ -100,6 +100,18 @@ GLint getGLCode(TexWrapParam p)
     return 0;
 }
 
+GLenum getGLCode(TextureTarget target)
+{
+    switch (target)
+    {
+    case TextureTarget::Texture2D:
+        return GL_TEXTURE_2D;
+    case TextureTarget::Texture2DArray:
+        return GL_TEXTURE_2D_ARRAY;
+    }
+    return 0;
+}
+
 GLenum getGLCode(ShaderType type)
 {
     using st = ShaderType;
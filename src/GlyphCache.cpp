@@ -0,0 +1,232 @@
+#include "GlyphCache.h"
+
+#include "IncludesGl.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <iostream>
+
+//! \brief the cache is never destroyed, its textures would outlive the GL context at exit anyway
+GlyphCache &GlyphCache::instance()
+{
+    static GlyphCache *cache = new GlyphCache();
+    return *cache;
+}
+
+//! \returns id of the style with name \p style_name, a new id is created for unknown names
+//!  glyphs of fonts with the same style name are rasterized only once
+std::uint32_t GlyphCache::getStyleId(const std::string &style_name)
+{
+    auto [it, inserted] = m_style_ids.try_emplace(style_name, static_cast<std::uint32_t>(m_style_ids.size()));
+    return it->second;
+}
+
+static std::uint64_t glyphKey(std::uint32_t style_id, int code)
+{
+    return (std::uint64_t(style_id) << 32) | std::uint32_t(code);
+}
+
+//! \returns glyph of \p code in style \p style_id or nullptr if it was not inserted yet
+const Character *GlyphCache::find(std::uint32_t style_id, int code) const
+{
+    auto it = m_glyphs.find(glyphKey(style_id, code));
+    return it == m_glyphs.end() ? nullptr : &it->second;
+}
+
+//! \brief reserves space in the atlas for the \p bitmap and gives it the next free place in the charmap texture
+//!  a bitmap which is not loaded gets an empty record, so that it is not rasterized again
+//! \returns the stored glyph
+const Character &GlyphCache::insert(std::uint32_t style_id, int code, GlyphBitmap bitmap)
+{
+    constexpr int safety_margin = 2; //! number of pixels that separate glyphs in texture
+    if (m_pages.empty())
+    {
+        addPage();
+    }
+
+    Character character = {m_pages.back()->getHandle(), {0, 0}, {0, 0}, {0, 0}, {0, 0, 0, 0}, 0};
+    if (bitmap.loaded)
+    {
+        int width = bitmap.size.x;
+        int rows = bitmap.size.y;
+        if (width + safety_margin > FONT_ATLAS_PAGE_SIZE || rows + safety_margin > FONT_ATLAS_PAGE_SIZE)
+        {
+            std::cout << "Glyph " << code << " does not fit into the font atlas!" << std::endl;
+            width = 0;
+            rows = 0;
+        }
+
+        if (m_pen.x + width + safety_margin > FONT_ATLAS_PAGE_SIZE) //! if we reach right side of the page
+        {
+            m_pen.y += m_row_height + safety_margin;
+            m_pen.x = 0;
+            m_row_height = 0;
+        }
+        if (m_pen.y + rows + safety_margin > FONT_ATLAS_PAGE_SIZE) //! page is full
+        {
+            addPage();
+        }
+
+        if (width > 0 && rows > 0)
+        {
+            m_pending_glyphs.push_back({m_pages.size() - 1, m_pen, {width, rows}, std::move(bitmap.pixels)});
+        }
+
+        character = {
+            m_pages.back()->getHandle(),
+            m_pen,
+            {width, rows},
+            bitmap.bearing,
+            bitmap.bb,
+            bitmap.advance};
+
+        m_pen.x += width + safety_margin; //! move position to next glyph
+        m_row_height = std::max(m_row_height, rows);
+    }
+
+    utils::Vector2f atlas_size = {FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE};
+    utils::Vector2f texrect_coords = {character.tex_coords.x / atlas_size.x, 1.f - character.tex_coords.y / atlas_size.y};
+    utils::Vector2f texrect_size = {character.size.x / atlas_size.x, character.size.y / atlas_size.y};
+    m_glyph_tex_rects.push_back({texrect_coords.x, texrect_coords.y, texrect_size.x, texrect_size.y});
+
+    character.tex_code = m_glyph_tex_rects.size() - 1;
+    character.tex_size = character.size;
+    return m_glyphs[glyphKey(style_id, code)] = character;
+}
+
+//! \brief starts a new empty page of the atlas, further glyphs are packed into it
+void GlyphCache::addPage()
+{
+    TextureOptions options;
+    options.data_type = TextureDataTypes::UByte;
+    options.format = TextureFormat::RGBA;
+    options.internal_format = TextureFormat::RGBA;
+    options.mag_param = TexMappingParam::Linear;
+    options.min_param = TexMappingParam::Linear;
+    options.mipmap_levels = 0;
+    options.mipmap_generation = MipmapGeneration::None;
+    auto &page = m_pages.emplace_back(std::make_unique<Texture>(FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE, options));
+
+    //! glyphs are sampled linearly, so the gaps between them must be empty
+    std::vector<unsigned char> zeros(FONT_ATLAS_PAGE_SIZE * FONT_ATLAS_PAGE_SIZE * 4, 0);
+    page->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, FONT_ATLAS_PAGE_SIZE, FONT_ATLAS_PAGE_SIZE,
+                    GL_RGBA, GL_UNSIGNED_BYTE, zeros.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glCheckError();
+
+    m_pen = {0, 0};
+    m_row_height = 0;
+}
+
+//! \brief sends all glyphs inserted since the last call to the atlas pages and updates the charmap texture
+void GlyphCache::uploadPendingGlyphs()
+{
+    std::size_t bound_page = m_pages.size();
+    for (auto &glyph : m_pending_glyphs)
+    {
+        if (glyph.page_index != bound_page)
+        {
+            m_pages.at(glyph.page_index)->bind();
+            bound_page = glyph.page_index;
+        }
+        //! tex_coords have y going down from the top of the page
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        glyph.tex_coords.x, FONT_ATLAS_PAGE_SIZE - glyph.tex_coords.y - glyph.size.y,
+                        glyph.size.x, glyph.size.y,
+                        GL_RGBA, GL_UNSIGNED_BYTE, glyph.pixels.data());
+        glCheckError();
+    }
+    if (!m_pending_glyphs.empty())
+    {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_pending_glyphs.clear();
+    }
+
+    renderCharMapTexture();
+}
+
+//! \brief writes glyph rects which are not yet in the charmap texture, the texture grows when needed
+//!  glyph with texcode i is at texel (i % FONT_CHARMAP_WIDTH, i / FONT_CHARMAP_WIDTH)
+void GlyphCache::renderCharMapTexture()
+{
+    std::size_t glyphs_count = m_glyph_tex_rects.size();
+    if (m_charmap_rows_count > 0 && m_uploaded_glyphs_count == glyphs_count)
+    {
+        return;
+    }
+
+    if (m_charmap_tex_id == 0)
+    {
+        glGenTextures(1, &m_charmap_tex_id);
+        glBindTexture(GL_TEXTURE_2D, m_charmap_tex_id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_charmap_tex_id);
+
+    int needed_rows = std::max<int>(1, (glyphs_count + FONT_CHARMAP_WIDTH - 1) / FONT_CHARMAP_WIDTH);
+    if (needed_rows > m_charmap_rows_count)
+    {
+        //! reallocate with doubled size, so that growing costs amortized constant time per glyph
+        int rows_count = std::max(1, m_charmap_rows_count);
+        while (rows_count < needed_rows)
+        {
+            rows_count *= 2;
+        }
+        std::vector<Rectf> glyph_tex_rects = m_glyph_tex_rects;
+        glyph_tex_rects.resize(rows_count * FONT_CHARMAP_WIDTH, {0, 0, 0, 0});
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, FONT_CHARMAP_WIDTH, rows_count, 0, GL_RGBA, GL_FLOAT, glyph_tex_rects.data());
+        m_charmap_rows_count = rows_count;
+    }
+    else
+    {
+        //! write only the new texels, row by row
+        std::size_t texcode = m_uploaded_glyphs_count;
+        while (texcode < glyphs_count)
+        {
+            int row = texcode / FONT_CHARMAP_WIDTH;
+            int column = texcode % FONT_CHARMAP_WIDTH;
+            int count = std::min<std::size_t>(FONT_CHARMAP_WIDTH - column, glyphs_count - texcode);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, column, row, count, 1, GL_RGBA, GL_FLOAT, &m_glyph_tex_rects.at(texcode));
+            texcode += count;
+        }
+    }
+    m_uploaded_glyphs_count = glyphs_count;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glCheckError();
+}
+
+std::size_t GlyphCache::getPagesCount() const
+{
+    return m_pages.size();
+}
+
+//! \returns page of the atlas with index \p page_index, the first page is created when needed
+Texture &GlyphCache::getPage(std::size_t page_index)
+{
+    if (m_pages.empty())
+    {
+        addPage();
+    }
+    return *m_pages.at(page_index);
+}
+
+//! \returns index of the page with OpenGL handle \p page_handle (getPagesCount() if there is no such page)
+std::size_t GlyphCache::getPageIndex(GLuint page_handle) const
+{
+    auto page_it = std::find_if(m_pages.begin(), m_pages.end(), [page_handle](auto &page)
+                                { return page->getHandle() == page_handle; });
+    return std::distance(m_pages.begin(), page_it);
+}
+
+GLuint GlyphCache::getCharmapTexId() const
+{
+    return m_charmap_tex_id;
+}
+
+std::size_t GlyphCache::getGlyphsCount() const
+{
+    return m_glyph_tex_rects.size();
+}
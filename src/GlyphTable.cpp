@@ -0,0 +1,56 @@
+#include "GlyphTable.h"
+
+GlyphTable::GlyphTable()
+{
+    clear();
+}
+
+bool GlyphTable::contains(int code) const
+{
+    return find(code) != nullptr;
+}
+
+//! \brief stores the \p character under the \p code, overwrites an existing record
+//! \param character    its tex_code has to be set (non-negative)
+//! \returns reference to the stored record
+Character &GlyphTable::insert(int code, const Character &character)
+{
+    if (static_cast<unsigned int>(code) >= PAGE_SIZE * PAGES_COUNT)
+    {
+        auto [it, inserted] = m_other_glyphs.insert_or_assign(code, character);
+        m_size += inserted;
+        return it->second;
+    }
+
+    auto &page = m_pages[code / PAGE_SIZE];
+    if (!page)
+    {
+        page = std::make_unique<Page>();
+        page->fill(Character{});
+    }
+    auto &record = (*page)[code % PAGE_SIZE];
+    m_size += record.tex_code < 0;
+    record = character;
+    return record;
+}
+
+//! \brief removes all glyphs, only the first page stays allocated
+void GlyphTable::clear()
+{
+    for (std::size_t page_id = 1; page_id < PAGES_COUNT; ++page_id)
+    {
+        m_pages[page_id].reset();
+    }
+    if (!m_pages[0])
+    {
+        m_pages[0] = std::make_unique<Page>();
+    }
+    m_pages[0]->fill(Character{});
+    m_other_glyphs.clear();
+    m_size = 0;
+}
+
+std::size_t GlyphTable::size() const
+{
+    return m_size;
+}
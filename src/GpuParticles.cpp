@@ -0,0 +1,257 @@
+#include "GpuParticles.h"
+
+#include "Renderer.h"
+#include "CommonShaders.inl"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+//! \struct GpuParticleState
+//! \brief layout of one particle in the state buffers, same as the outputs of the simulation shader
+struct GpuParticleState
+{
+    utils::Vector2f pos = {0, 0};
+    utils::Vector2f vel = {0, 0};
+    float time = 1.f;      //!< starts larger than life_time, so that all slots begin dead
+    float life_time = 0.f;
+};
+
+//! \brief enables float attribute \p attrib_id read from the state buffer bound to GL_ARRAY_BUFFER
+static void setStateAttribute(GLuint attrib_id, int count, std::size_t offset, GLuint divisor)
+{
+    glEnableVertexAttribArray(attrib_id);
+    glVertexAttribPointer(attrib_id, count, GL_FLOAT, GL_FALSE, sizeof(GpuParticleState), (void *)offset);
+    glVertexAttribDivisor(attrib_id, divisor);
+}
+
+//! \brief creates GPU buffers and shaders for at most \p n_max_particles particles
+//! \param n_max_particles  number of slots in the state buffers
+GpuParticles::GpuParticles(int n_max_particles)
+    : m_capacity(std::max(n_max_particles, 1))
+{
+    m_simulation_shader.setTransformFeedbackVaryings({"v_pos", "v_vel", "v_time", "v_life_time"});
+    if (!m_simulation_shader.loadFromCode(vertex_gpu_particles_simulation_code, fragment_gpu_particles_simulation_code) ||
+        !m_draw_shader.loadFromCode(vertex_gpu_particles_code, fragment_fullpass_code))
+    {
+        throw std::runtime_error("GpuParticles shaders failed to build!");
+    }
+
+    static constexpr float VERTEX_RECT[6 * 4] = {
+        -1, -1, 0, 0,
+        -1, +1, 0, 1,
+        +1, -1, 1, 0,
+        +1, +1, 1, 1,
+        +1, -1, 1, 0,
+        -1, +1, 0, 1};
+    glGenBuffers(1, &m_quad_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(VERTEX_RECT), VERTEX_RECT, GL_STATIC_DRAW);
+
+    std::vector<GpuParticleState> dead_particles(m_capacity);
+    glGenBuffers(2, m_state_buffers);
+    glGenVertexArrays(2, m_simulation_vaos);
+    glGenVertexArrays(2, m_draw_vaos);
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_state_buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(GpuParticleState) * m_capacity, dead_particles.data(), GL_DYNAMIC_COPY);
+
+        glBindVertexArray(m_simulation_vaos[i]);
+        setStateAttribute(0, 2, offsetof(GpuParticleState, pos), 0);
+        setStateAttribute(1, 2, offsetof(GpuParticleState, vel), 0);
+        setStateAttribute(2, 1, offsetof(GpuParticleState, time), 0);
+        setStateAttribute(3, 1, offsetof(GpuParticleState, life_time), 0);
+
+        //! one quad per particle: the quad is per vertex, the state is per instance
+        glBindVertexArray(m_draw_vaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_quad_buffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(0 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, m_state_buffers[i]);
+        setStateAttribute(2, 2, offsetof(GpuParticleState, pos), 1);
+        setStateAttribute(3, 1, offsetof(GpuParticleState, time), 1);
+        setStateAttribute(4, 1, offsetof(GpuParticleState, life_time), 1);
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTransformFeedbacks(1, &m_feedback);
+    glCheckErrorMsg("Error in GpuParticles creation");
+}
+
+GpuParticles::~GpuParticles()
+{
+    glDeleteTransformFeedbacks(1, &m_feedback);
+    glDeleteVertexArrays(2, m_draw_vaos);
+    glDeleteVertexArrays(2, m_simulation_vaos);
+    glDeleteBuffers(2, m_state_buffers);
+    glDeleteBuffers(1, &m_quad_buffer);
+}
+
+//! \returns number of particles born during the time step \p dt
+std::size_t GpuParticles::countEmitted(float dt)
+{
+    m_spawn_timer += dt;
+    if (m_spawn_period <= 0.f || m_spawn_timer < m_spawn_period)
+    {
+        return 0;
+    }
+    const float elapsed_periods = std::floor(m_spawn_timer / m_spawn_period);
+    m_spawn_timer -= elapsed_periods * m_spawn_period;
+
+    //! more than m_capacity particles in one step would overwrite each other in the ring of slots
+    std::size_t max_count = m_capacity;
+    if (!m_repeats)
+    {
+        max_count = m_capacity - std::min(m_spawned_count, m_capacity);
+    }
+    const auto emitted_count = static_cast<std::size_t>(std::min(elapsed_periods, static_cast<float>(max_count)));
+    m_spawned_count += emitted_count;
+    return emitted_count;
+}
+
+//! \brief emits new particles and moves all of them by one time step, everything happens on the GPU
+//! \param dt time step
+void GpuParticles::update(float dt)
+{
+    m_time += dt;
+    auto emitted_count = countEmitted(dt);
+
+    m_simulation_shader.setUniform("u_dt", dt);
+    m_simulation_shader.setUniform("u_seed", m_time);
+    m_simulation_shader.setUniform("u_emit_first", static_cast<int>(m_next_slot));
+    m_simulation_shader.setUniform("u_emit_count", static_cast<int>(emitted_count));
+    m_simulation_shader.setUniform("u_capacity", static_cast<int>(m_capacity));
+    m_simulation_shader.setUniform("u_spawn_pos", glm::vec2(m_spawn_pos.x, m_spawn_pos.y));
+    m_simulation_shader.setUniform("u_speed_range", glm::vec2(m_speed_range.x, m_speed_range.y));
+    m_simulation_shader.setUniform("u_lifetime", m_lifetime);
+    m_simulation_shader.setUniform("u_acceleration", glm::vec2(m_acceleration.x, m_acceleration.y));
+    m_simulation_shader.setUniform("u_drag", m_drag);
+    m_simulation_shader.use();
+
+    //! read the current buffer, write the other one, nothing is rasterized
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(m_simulation_vaos[m_current]);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, m_feedback);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_state_buffers[1 - m_current]);
+
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, m_capacity);
+    glEndTransformFeedback();
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glCheckErrorMsg("Error in GpuParticles simulation");
+
+    m_current = 1 - m_current;
+    m_next_slot = (m_next_slot + emitted_count) % m_capacity;
+}
+
+//! \brief draws the particles into the target of \p canvas with its view, viewport and blend factors
+//! \brief the draw call is done immediately, so it is not ordered with the batches drawn by canvas.drawAll()
+//! \param canvas
+void GpuParticles::draw(Renderer &canvas)
+{
+    auto &target = canvas.getTarget();
+    target.bind();
+    glViewport(canvas.m_viewport.pos_x * target.getSize().x,
+               canvas.m_viewport.pos_y * target.getSize().y,
+               canvas.m_viewport.width * target.getSize().x,
+               canvas.m_viewport.height * target.getSize().y);
+    setBlendParams(canvas.m_blend_factors);
+
+    m_draw_shader.setUniform("u_view_projection", canvas.m_view.getMatrix());
+    m_draw_shader.setUniform("u_init_color", glm::vec4(m_init_color.r, m_init_color.g, m_init_color.b, m_init_color.a));
+    m_draw_shader.setUniform("u_final_color", glm::vec4(m_final_color.r, m_final_color.g, m_final_color.b, m_final_color.a));
+    m_draw_shader.setUniform("u_size", glm::vec2(m_size.x, m_size.y));
+    m_draw_shader.use();
+
+    glBindVertexArray(m_draw_vaos[m_current]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, m_capacity);
+    glBindVertexArray(0);
+    glCheckErrorMsg("Error in GpuParticles draw");
+}
+
+void GpuParticles::setSpawnPos(utils::Vector2f pos)
+{
+    m_spawn_pos = pos;
+}
+
+utils::Vector2f GpuParticles::getSpawnPos() const
+{
+    return m_spawn_pos;
+}
+
+void GpuParticles::setInitColor(Color color)
+{
+    m_init_color = color;
+}
+
+void GpuParticles::setFinalColor(Color color)
+{
+    m_final_color = color;
+}
+
+void GpuParticles::setLifetime(float lifetime)
+{
+    m_lifetime = lifetime;
+}
+
+void GpuParticles::setRepeat(bool repeats)
+{
+    m_repeats = repeats;
+}
+
+bool GpuParticles::getRepeat() const
+{
+    return m_repeats;
+}
+
+//! \brief sets time between two spawns, periods <= 0 are ignored
+void GpuParticles::setPeriod(float period)
+{
+    if (period > 0.f)
+    {
+        m_spawn_period = period;
+    }
+}
+
+float GpuParticles::getPeriod() const
+{
+    return m_spawn_period;
+}
+
+//! \brief new particles fly in a random direction with speed drawn uniformly from [\p min_speed, \p max_speed]
+void GpuParticles::setInitialSpeed(float min_speed, float max_speed)
+{
+    m_speed_range = {min_speed, max_speed};
+}
+
+//! \brief sets acceleration acting on all particles (e.g. gravity or wind)
+void GpuParticles::setAcceleration(utils::Vector2f acceleration)
+{
+    m_acceleration = acceleration;
+}
+
+//! \brief sets part of the velocity lost per second
+void GpuParticles::setDrag(float drag)
+{
+    m_drag = drag;
+}
+
+//! \brief particle size changes linearly from \p init_size at birth to \p final_size at the end of its life
+void GpuParticles::setSize(float init_size, float final_size)
+{
+    m_size = {init_size, final_size};
+}
+
+std::size_t GpuParticles::capacity() const
+{
+    return m_capacity;
+}
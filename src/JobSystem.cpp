@@ -0,0 +1,153 @@
+#include "Utils/JobSystem.h"
+
+#include <algorithm>
+
+namespace utils
+{
+
+    //! \brief starts \p n_threads - 1 workers, the thread calling parallelFor is the last one
+    //! \param n_threads    total number of threads doing the jobs (at least 1, always 1 in the browser)
+    JobSystem::JobSystem(std::size_t n_threads)
+    {
+        n_threads = std::max<std::size_t>(n_threads, 1);
+#ifdef __EMSCRIPTEN__ //! no threads without -pthread in the browser, parallelFor runs the jobs inline
+        n_threads = 1;
+#endif
+        for (std::size_t i = 0; i < n_threads; ++i)
+        {
+            m_queues.push_back(std::make_unique<JobQueue>());
+        }
+        for (std::size_t i = 1; i < n_threads; ++i)
+        {
+            m_workers.emplace_back([this, i]()
+                                   { workerLoop(i); });
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::scoped_lock lock(m_wake_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    //! \brief calls \p job with every index in [0, \p jobs_count) and returns when all calls finished
+    //! \brief jobs run concurrently, so they must not write the same data
+    //! \param jobs_count
+    //! \param job
+    void JobSystem::parallelFor(std::size_t jobs_count, const Job &job)
+    {
+        if (jobs_count == 0)
+        {
+            return;
+        }
+        if (m_workers.empty())
+        {
+            for (std::size_t i = 0; i < jobs_count; ++i)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        m_job = &job;
+        m_remaining = jobs_count;
+        //! neighbouring jobs go to the same thread, they often touch neighbouring data
+        const auto n_threads = m_queues.size();
+        const auto per_thread = (jobs_count + n_threads - 1) / n_threads;
+        for (std::size_t thread_index = 0; thread_index < n_threads; ++thread_index)
+        {
+            auto first = std::min(jobs_count, thread_index * per_thread);
+            auto last = std::min(jobs_count, first + per_thread);
+            std::scoped_lock lock(m_queues[thread_index]->mutex);
+            for (auto i = first; i < last; ++i)
+            {
+                m_queues[thread_index]->job_indices.push_back(i);
+            }
+        }
+        {
+            std::scoped_lock lock(m_wake_mutex);
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        //! the caller works too instead of just waiting
+        while (m_remaining > 0)
+        {
+            if (!runOneJob(0))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::size_t JobSystem::getThreadsCount() const
+    {
+        return m_queues.size();
+    }
+
+    //! \brief runs one job from the own queue of the thread or one stolen from another queue
+    //! \returns false if all queues are empty
+    bool JobSystem::runOneJob(std::size_t thread_index)
+    {
+        std::size_t job_index = 0;
+        bool found = false;
+        {
+            auto &own_queue = *m_queues[thread_index];
+            std::scoped_lock lock(own_queue.mutex);
+            if (!own_queue.job_indices.empty())
+            {
+                job_index = own_queue.job_indices.back();
+                own_queue.job_indices.pop_back();
+                found = true;
+            }
+        }
+        for (std::size_t i = 1; i < m_queues.size() && !found; ++i)
+        {
+            auto &victim_queue = *m_queues[(thread_index + i) % m_queues.size()];
+            std::scoped_lock lock(victim_queue.mutex);
+            if (!victim_queue.job_indices.empty())
+            {
+                job_index = victim_queue.job_indices.front();
+                victim_queue.job_indices.pop_front();
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+
+        (*m_job)(job_index);
+        m_remaining--;
+        return true;
+    }
+
+    void JobSystem::workerLoop(std::size_t thread_index)
+    {
+        std::size_t seen_generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_wake_mutex);
+                m_wake.wait(lock, [this, seen_generation]()
+                            { return m_stopping || m_generation != seen_generation; });
+                if (m_stopping)
+                {
+                    return;
+                }
+                seen_generation = m_generation;
+            }
+            while (runOneJob(thread_index))
+            {
+            }
+        }
+    }
+
+} // namespace utils
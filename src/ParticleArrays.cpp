@@ -0,0 +1,231 @@
+#include "ParticleArrays.h"
+
+#include "Utils/Simd.h"
+
+#include <algorithm>
+
+Particle::Particle(utils::Vector2f init_pos, utils::Vector2f init_vel, utils::Vector2f acc, utils::Vector2f scale,
+                   Color color, float life_time)
+    : pos(init_pos), vel(init_vel), acc(acc), scale(scale), color(color), life_time(life_time)
+{
+}
+
+//! \returns views of \p count particles starting at \p first
+ParticleSpans ParticleSpans::subspan(std::size_t first, std::size_t count) const
+{
+    return {pos_x.subspan(first, count), pos_y.subspan(first, count),
+            vel_x.subspan(first, count), vel_y.subspan(first, count),
+            acc_x.subspan(first, count), acc_y.subspan(first, count),
+            scale_x.subspan(first, count), scale_y.subspan(first, count),
+            angle.subspan(first, count),
+            color_r.subspan(first, count), color_g.subspan(first, count),
+            color_b.subspan(first, count), color_a.subspan(first, count),
+            time.subspan(first, count), life_time.subspan(first, count)};
+}
+
+//! \brief constructs arrays for at most \p capacity particles
+ParticleArrays::ParticleArrays(std::size_t capacity)
+{
+    setCapacity(capacity);
+}
+
+template <class Function>
+void ParticleArrays::forEachArray(Function function)
+{
+    function(m_pos_x);
+    function(m_pos_y);
+    function(m_vel_x);
+    function(m_vel_y);
+    function(m_acc_x);
+    function(m_acc_y);
+    function(m_scale_x);
+    function(m_scale_y);
+    function(m_angle);
+    function(m_color_r);
+    function(m_color_g);
+    function(m_color_b);
+    function(m_color_a);
+    function(m_time);
+    function(m_life_time);
+}
+
+//! \brief changes maximum number of particles, particles above the new capacity are thrown away
+void ParticleArrays::setCapacity(std::size_t capacity)
+{
+    forEachArray([capacity](auto &array)
+                 { array.resize(capacity); });
+    m_size = std::min(m_size, capacity);
+}
+
+std::size_t ParticleArrays::capacity() const
+{
+    return m_pos_x.size();
+}
+
+std::size_t ParticleArrays::size() const
+{
+    return m_size;
+}
+
+void ParticleArrays::clear()
+{
+    m_size = 0;
+}
+
+//! \brief adds the \p particle behind the live ones
+//! \returns false if the arrays are full
+bool ParticleArrays::push(const Particle &particle)
+{
+    if (m_size >= capacity())
+    {
+        return false;
+    }
+    auto i = m_size++;
+    m_pos_x[i] = particle.pos.x;
+    m_pos_y[i] = particle.pos.y;
+    m_vel_x[i] = particle.vel.x;
+    m_vel_y[i] = particle.vel.y;
+    m_acc_x[i] = particle.acc.x;
+    m_acc_y[i] = particle.acc.y;
+    m_scale_x[i] = particle.scale.x;
+    m_scale_y[i] = particle.scale.y;
+    m_angle[i] = particle.angle;
+    m_color_r[i] = particle.color.r;
+    m_color_g[i] = particle.color.g;
+    m_color_b[i] = particle.color.b;
+    m_color_a[i] = particle.color.a;
+    m_time[i] = particle.time;
+    m_life_time[i] = particle.life_time;
+    return true;
+}
+
+//! \returns copy of the particle at \p index gathered from all arrays
+Particle ParticleArrays::get(std::size_t index) const
+{
+    Particle particle({m_pos_x.at(index), m_pos_y.at(index)}, {m_vel_x[index], m_vel_y[index]},
+                      {m_acc_x[index], m_acc_y[index]}, {m_scale_x[index], m_scale_y[index]},
+                      {m_color_r[index], m_color_g[index], m_color_b[index], m_color_a[index]}, m_life_time[index]);
+    particle.angle = m_angle[index];
+    particle.time = m_time[index];
+    return particle;
+}
+
+//! \returns views of all live particles
+ParticleSpans ParticleArrays::spans()
+{
+    return {{m_pos_x.data(), m_size}, {m_pos_y.data(), m_size},
+            {m_vel_x.data(), m_size}, {m_vel_y.data(), m_size},
+            {m_acc_x.data(), m_size}, {m_acc_y.data(), m_size},
+            {m_scale_x.data(), m_size}, {m_scale_y.data(), m_size},
+            {m_angle.data(), m_size},
+            {m_color_r.data(), m_size}, {m_color_g.data(), m_size},
+            {m_color_b.data(), m_size}, {m_color_a.data(), m_size},
+            {m_time.data(), m_size}, {m_life_time.data(), m_size}};
+}
+
+//! \brief removes particles which lived longer than their life time in a single pass
+//!  a dead particle is replaced by the last live one, so the order of particles changes
+//! \returns number of removed particles
+std::size_t ParticleArrays::removeDead()
+{
+    std::size_t removed_count = 0;
+    std::size_t i = 0;
+    while (i < m_size)
+    {
+        if (m_time[i] <= m_life_time[i])
+        {
+            ++i;
+            continue;
+        }
+        auto last = --m_size;
+        forEachArray([i, last](auto &array)
+                     { array[i] = array[last]; });
+        removed_count++;
+    }
+    return removed_count;
+}
+
+namespace particle_kernels
+{
+    using namespace utils::simd;
+
+    //! \brief semi-implicit Euler step: velocity is updated first, the position moves with the new velocity
+    void integrateEuler(const ParticleSpans &particles, float dt)
+    {
+        const std::size_t count = particles.size();
+        const auto dt_pack = broadcast(dt);
+        float *pos[2] = {particles.pos_x.data(), particles.pos_y.data()};
+        float *vel[2] = {particles.vel_x.data(), particles.vel_y.data()};
+        const float *acc[2] = {particles.acc_x.data(), particles.acc_y.data()};
+        for (int axis = 0; axis < 2; ++axis) //! one axis at a time keeps just three streams in flight
+        {
+            std::size_t i = 0;
+            for (; i + FLOATS_WIDTH <= count; i += FLOATS_WIDTH)
+            {
+                auto new_vel = mulAdd(load(acc[axis] + i), dt_pack, load(vel[axis] + i));
+                store(vel[axis] + i, new_vel);
+                store(pos[axis] + i, mulAdd(new_vel, dt_pack, load(pos[axis] + i)));
+            }
+            for (; i < count; ++i)
+            {
+                vel[axis][i] += acc[axis][i] * dt;
+                pos[axis][i] += vel[axis][i] * dt;
+            }
+        }
+    }
+
+    //! \brief advances time of all particles by \p dt
+    void age(const ParticleSpans &particles, float dt)
+    {
+        const std::size_t count = particles.size();
+        const auto dt_pack = broadcast(dt);
+        float *time = particles.time.data();
+        std::size_t i = 0;
+        for (; i + FLOATS_WIDTH <= count; i += FLOATS_WIDTH)
+        {
+            store(time + i, load(time + i) + dt_pack);
+        }
+        for (; i < count; ++i)
+        {
+            time[i] += dt;
+        }
+    }
+
+    //! \brief sets colors linearly between \p init_color (at birth) and \p final_color (at the end of life)
+    void interpolateColors(const ParticleSpans &particles, Color init_color, Color final_color)
+    {
+        const std::size_t count = particles.size();
+        const float *time = particles.time.data();
+        const float *life_time = particles.life_time.data();
+        float *channels[4] = {particles.color_r.data(), particles.color_g.data(), particles.color_b.data(), particles.color_a.data()};
+        const float init[4] = {init_color.r, init_color.g, init_color.b, init_color.a};
+        const float delta[4] = {final_color.r - init_color.r, final_color.g - init_color.g,
+                                final_color.b - init_color.b, final_color.a - init_color.a};
+
+        const auto zero = broadcast(0.f);
+        const auto one = broadcast(1.f);
+        std::size_t i = 0;
+        for (; i + FLOATS_WIDTH <= count; i += FLOATS_WIDTH)
+        {
+            auto ratio = min(max(load(time + i) / load(life_time + i), zero), one);
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                store(channels[channel] + i, mulAdd(ratio, broadcast(delta[channel]), broadcast(init[channel])));
+            }
+        }
+        for (; i < count; ++i)
+        {
+            float ratio = std::min(std::max(time[i] / life_time[i], 0.f), 1.f);
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                channels[channel][i] = init[channel] + delta[channel] * ratio;
+            }
+        }
+    }
+
+    //! \returns name of the SIMD instruction set the kernels were compiled for
+    const char *getInstructionSet()
+    {
+        return INSTRUCTION_SET;
+    }
+} // namespace particle_kernels
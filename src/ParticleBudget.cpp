@@ -0,0 +1,165 @@
+#include "ParticleBudget.h"
+
+#include <algorithm>
+
+//! \param max_particles    cap of live particles of all registered emitters
+//! \param frame_budget_ms  frame time to keep, in milliseconds
+ParticleBudget::ParticleBudget(std::size_t max_particles, float frame_budget_ms)
+    : m_max_particles(max_particles), m_frame_budget_ms(frame_budget_ms), m_smoothed_frame_time_ms(frame_budget_ms)
+{
+}
+
+template <class EmitterT>
+void ParticleBudget::addEmitter(EmitterT &emitter, int priority)
+{
+    Entry entry = {&emitter, priority,
+                   [&emitter]()
+                   { return emitter.getBounds(); },
+                   [&emitter]()
+                   { return emitter.size(); },
+                   [&emitter](float dt)
+                   { return emitter.getExpectedSpawnCount(dt); },
+                   [&emitter](float spawn_scale, float draw_fraction)
+                   {
+                       emitter.setSpawnScale(spawn_scale);
+                       emitter.setDrawFraction(draw_fraction);
+                   }};
+    //! emitters of the same priority keep the order in which they were added
+    auto place = std::upper_bound(m_entries.begin(), m_entries.end(), priority, [](int new_priority, const Entry &other)
+                                  { return new_priority > other.priority; });
+    m_entries.insert(place, std::move(entry));
+}
+
+//! \brief registers \p emitter, emitters with higher \p priority get room under the particle cap first
+void ParticleBudget::add(Particles &emitter, int priority)
+{
+    addEmitter(emitter, priority);
+}
+
+//! \brief registers \p emitter, emitters with higher \p priority get room under the particle cap first
+void ParticleBudget::add(ParticleSystem &emitter, int priority)
+{
+    addEmitter(emitter, priority);
+}
+
+//! \brief unregisters \p emitter, it keeps the last spawn scale and draw fraction it got
+void ParticleBudget::remove(const Particles &emitter)
+{
+    std::erase_if(m_entries, [&emitter](const Entry &entry)
+                  { return entry.emitter == &emitter; });
+}
+
+//! \brief unregisters \p emitter, it keeps the last spawn scale and draw fraction it got
+void ParticleBudget::remove(const ParticleSystem &emitter)
+{
+    std::erase_if(m_entries, [&emitter](const Entry &entry)
+                  { return entry.emitter == &emitter; });
+}
+
+void ParticleBudget::clear()
+{
+    m_entries.clear();
+}
+
+//! \brief changes the quality according to the time of the last frame
+//! \brief a spike (e.g. an explosion) lowers it at once, recovery is slow, so that the quality does not oscillate
+void ParticleBudget::updateQuality(float frame_time_ms)
+{
+    m_smoothed_frame_time_ms += (frame_time_ms - m_smoothed_frame_time_ms) * 0.1f;
+    if (frame_time_ms > 1.5f * m_frame_budget_ms)
+    {
+        m_quality *= m_frame_budget_ms / frame_time_ms;
+    }
+    else if (m_smoothed_frame_time_ms > m_frame_budget_ms)
+    {
+        m_quality *= 0.95f;
+    }
+    else if (m_smoothed_frame_time_ms < 0.9f * m_frame_budget_ms)
+    {
+        m_quality += 0.02f;
+    }
+    m_quality = std::clamp(m_quality, m_min_quality, 1.f);
+}
+
+//! \brief sets spawn scales and draw fractions of all registered emitters for the coming frame
+//! \param view             emitters outside of it are culled
+//! \param frame_time_ms    duration of the last frame in milliseconds
+//! \param dt               time step of the coming update
+void ParticleBudget::update(const View &view, float frame_time_ms, float dt)
+{
+    updateQuality(frame_time_ms);
+
+    m_live_count = 0;
+    for (auto &entry : m_entries)
+    {
+        m_live_count += entry.get_count();
+    }
+
+    m_visible_count = 0;
+    float room = static_cast<float>(m_max_particles) - static_cast<float>(m_live_count);
+    for (auto &entry : m_entries)
+    {
+        auto bounds = entry.get_bounds();
+        bounds = {bounds.pos_x - m_cull_margin, bounds.pos_y - m_cull_margin,
+                  bounds.width + 2.f * m_cull_margin, bounds.height + 2.f * m_cull_margin};
+        if (!view.intersects(bounds))
+        {
+            entry.apply(0.f, 0.f);
+            continue;
+        }
+        m_visible_count++;
+
+        //! the emitter gets at most as much room as is left after emitters with higher priority
+        const float wanted = entry.get_spawn_count(dt) * m_quality;
+        const float granted = std::clamp(room, 0.f, wanted);
+        room -= granted;
+        const float spawn_scale = wanted > 0.f ? m_quality * granted / wanted : 0.f;
+        entry.apply(spawn_scale, m_quality);
+    }
+}
+
+void ParticleBudget::setMaxParticles(std::size_t max_particles)
+{
+    m_max_particles = max_particles;
+}
+
+std::size_t ParticleBudget::getMaxParticles() const
+{
+    return m_max_particles;
+}
+
+//! \brief sets frame time to keep, in milliseconds
+void ParticleBudget::setFrameBudget(float frame_budget_ms)
+{
+    m_frame_budget_ms = frame_budget_ms;
+}
+
+//! \brief the quality never gets below \p min_quality, so visible effects never disappear completely
+void ParticleBudget::setMinQuality(float min_quality)
+{
+    m_min_quality = std::clamp(min_quality, 0.f, 1.f);
+}
+
+//! \brief emitters closer than \p margin to the view are not culled, so that effects do not pop at its edges
+void ParticleBudget::setCullMargin(float margin)
+{
+    m_cull_margin = margin;
+}
+
+//! \returns 1 when there is enough time, down to the min. quality when frames are too slow
+float ParticleBudget::getQuality() const
+{
+    return m_quality;
+}
+
+//! \returns number of live particles of all registered emitters at the last update
+std::size_t ParticleBudget::getLiveCount() const
+{
+    return m_live_count;
+}
+
+//! \returns number of emitters which were not culled at the last update
+std::size_t ParticleBudget::getVisibleCount() const
+{
+    return m_visible_count;
+}
@@ -0,0 +1,106 @@
+#include "ParticleInteractions.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace particle_interactions
+{
+
+    //! \returns distance up to which particles interact, 0 if there are no forces
+    float PairForces::getRadius() const
+    {
+        return std::max(repulsion != 0.f ? repulsion_radius : 0.f, attraction != 0.f ? attraction_radius : 0.f);
+    }
+
+    //! \brief pushes particles away from their close neighbours and pulls them towards the further ones
+    //! \brief both forces are summed in one neighbour query
+    //! \param particles    all particles, the \p grid must have been built from their positions
+    //! \param first        first particle whose velocity changes
+    //! \param count        number of particles whose velocity changes
+    //! \param grid
+    //! \param forces
+    //! \param dt           time step
+    void applyPairForces(const ParticleSpans &particles, std::size_t first, std::size_t count,
+                         const utils::SpatialGrid &grid, const PairForces &forces, float dt)
+    {
+        const float radius = forces.getRadius();
+        if (radius <= 0.f)
+        {
+            return;
+        }
+        const float repulsion = forces.repulsion_radius > 0.f ? forces.repulsion : 0.f;
+        const float attraction = forces.attraction_radius > 0.f ? forces.attraction : 0.f;
+        const float inv_repulsion_radius = repulsion != 0.f ? 1.f / forces.repulsion_radius : 0.f;
+        const float inv_attraction_radius = attraction != 0.f ? 1.f / forces.attraction_radius : 0.f;
+        for (auto i = first; i < first + count; ++i)
+        {
+            utils::Vector2f dv = {0.f, 0.f};
+            grid.forEachNeighbour({particles.pos_x[i], particles.pos_y[i]}, radius,
+                                  [&](std::size_t neighbour, utils::Vector2f offset)
+                                  {
+                                      float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+                                      if (neighbour == i || distance == 0.f)
+                                      {
+                                          return;
+                                      }
+                                      //! each force is zero beyond its radius
+                                      float pull = attraction * std::max(0.f, 1.f - distance * inv_attraction_radius) -
+                                                   repulsion * std::max(0.f, 1.f - distance * inv_repulsion_radius);
+                                      float magnitude = pull / distance;
+                                      dv.x += offset.x * magnitude;
+                                      dv.y += offset.y * magnitude;
+                                  });
+            particles.vel_x[i] += dv.x * dt;
+            particles.vel_y[i] += dv.y * dt;
+        }
+    }
+
+    //! \brief moves particles found inside \p colliders out through the nearest side and bounces them off it
+    //! \param particles
+    //! \param colliders
+    //! \param restitution  part of the velocity kept after the bounce (0 stops, 1 is a perfect bounce)
+    void collideWithRects(const ParticleSpans &particles, std::span<const Rectf> colliders, float restitution)
+    {
+        for (auto &collider : colliders)
+        {
+            const float min_x = collider.pos_x;
+            const float max_x = collider.pos_x + collider.width;
+            const float min_y = collider.pos_y;
+            const float max_y = collider.pos_y + collider.height;
+            for (std::size_t i = 0; i < particles.size(); ++i)
+            {
+                const float x = particles.pos_x[i];
+                const float y = particles.pos_y[i];
+                if (x <= min_x || x >= max_x || y <= min_y || y >= max_y)
+                {
+                    continue;
+                }
+
+                const float to_left = x - min_x;
+                const float to_right = max_x - x;
+                const float to_bottom = y - min_y;
+                const float to_top = max_y - y;
+                const float nearest = std::min(std::min(to_left, to_right), std::min(to_bottom, to_top));
+                if (nearest == to_left || nearest == to_right)
+                {
+                    const float direction = nearest == to_left ? -1.f : 1.f;
+                    particles.pos_x[i] = nearest == to_left ? min_x : max_x;
+                    if (particles.vel_x[i] * direction < 0.f)
+                    {
+                        particles.vel_x[i] *= -restitution;
+                    }
+                }
+                else
+                {
+                    const float direction = nearest == to_bottom ? -1.f : 1.f;
+                    particles.pos_y[i] = nearest == to_bottom ? min_y : max_y;
+                    if (particles.vel_y[i] * direction < 0.f)
+                    {
+                        particles.vel_y[i] *= -restitution;
+                    }
+                }
+            }
+        }
+    }
+
+} // namespace particle_interactions
@@ -0,0 +1,94 @@
+#include "ParticleSorting.h"
+
+#include <algorithm>
+
+//! \returns blending of the batch with the particles, empty if the batch uses the blending of the renderer
+std::optional<BlendParams> getBlendParams(ParticleBlending blending)
+{
+    switch (blending)
+    {
+    case ParticleBlending::Alpha:
+        return BlendParams{BlendFactor::SrcAlpha, BlendFactor::OneMinusSrcAlpha, BlendFactor::One, BlendFactor::OneMinusSrcAlpha};
+    case ParticleBlending::Premultiplied:
+        return BlendParams{BlendFactor::One, BlendFactor::OneMinusSrcAlpha};
+    case ParticleBlending::Additive:
+        return BlendParams{BlendFactor::SrcAlpha, BlendFactor::One, BlendFactor::Zero, BlendFactor::One};
+    default:
+        return std::nullopt;
+    }
+}
+
+//! \brief keeps only \p fraction of \p instances, evenly spread over them, so that the draw order is kept
+//! \param instances
+//! \param fraction    from [0, 1], with 1 nothing is removed
+void thinOutInstances(std::vector<ParticleInstance> &instances, float fraction)
+{
+    instances.resize(thinOutInstances(instances.data(), instances.size(), fraction));
+}
+
+//! \brief moves the kept instances of \p count instances starting at \p instances to the front (see above)
+//! \returns number of kept instances
+std::size_t thinOutInstances(ParticleInstance *instances, std::size_t count, float fraction)
+{
+    if (fraction >= 1.f)
+    {
+        return count;
+    }
+    const auto kept_count = static_cast<std::size_t>(count * std::max(fraction, 0.f));
+    for (std::size_t i = 0; i < kept_count; ++i)
+    {
+        instances[i] = instances[i * count / kept_count];
+    }
+    return kept_count;
+}
+
+//! \brief reorders \p instances into the draw order
+//! \param instances    instances of one emitter
+//! \param ages         ages[i] is the age of the particle of instances[i], only read when sorting by age
+//! \param order
+//! \param blending     additive particles are left as they are, their order does not change the result
+void ParticleSorter::sort(std::vector<ParticleInstance> &instances, const float *ages, ParticleOrder order, ParticleBlending blending)
+{
+    if (sortInto(instances.data(), instances.size(), ages, order, blending))
+    {
+        instances.swap(m_sorted);
+    }
+}
+
+//! \brief reorders \p count instances starting at \p instances into the draw order (see above)
+void ParticleSorter::sort(ParticleInstance *instances, std::size_t count, const float *ages, ParticleOrder order, ParticleBlending blending)
+{
+    if (sortInto(instances, count, ages, order, blending))
+    {
+        std::copy(m_sorted.begin(), m_sorted.end(), instances);
+    }
+}
+
+//! \brief writes \p instances in the draw order into m_sorted
+//! \returns false if the instances stay as they are, m_sorted is then left untouched
+bool ParticleSorter::sortInto(const ParticleInstance *instances, std::size_t count, const float *ages, ParticleOrder order, ParticleBlending blending)
+{
+    if (order == ParticleOrder::None || blending == ParticleBlending::Additive || count < 2)
+    {
+        return false;
+    }
+
+    const float *keys = ages;
+    if (order == ParticleOrder::ByDepth)
+    {
+        m_keys.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            m_keys[i] = instances[i].pos.y;
+        }
+        keys = m_keys.data();
+    }
+
+    auto &sorted_indices = m_sorter.sort(keys, count);
+    m_sorted.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        m_sorted[i] = instances[sorted_indices[i]];
+    }
+    return true;
+}
@@ -0,0 +1,392 @@
+#include "ParticleSystem.h"
+
+#include "Utils/RandomTools.h"
+
+#include <algorithm>
+#include <cmath>
+
+//! \brief constructs from maximum number of particles
+//! \param n_max_particles maximum number of particles
+ParticleSystem::ParticleSystem(int n_max_particles)
+    : m_particles(n_max_particles), m_rng(makeEmitterRng())
+{
+}
+
+//! \brief spawns particles, runs the interactions, the built-in kernels and the updater,
+//! \brief then destroys particles that are dead
+//! \param dt time step
+void ParticleSystem::update(float dt)
+{
+    spawnParticles(dt);
+    buildGrid();
+    interact(0, m_particles.size(), dt);
+    simulate(0, m_particles.size(), dt);
+    removeDeadParticles();
+}
+
+//! \brief sorts current positions of the particles into the grid (see getGrid)
+//! \brief the grid is built only if some pair force is set or the cell size was set by setGridCellSize
+void ParticleSystem::buildGrid()
+{
+    const float cell_size = m_grid_cell_size > 0.f ? m_grid_cell_size : m_pair_forces.getRadius();
+    if (cell_size <= 0.f)
+    {
+        m_grid.clear();
+        return;
+    }
+    m_grid.setCellSize(cell_size);
+    auto particles = m_particles.spans();
+    m_grid.build(particles.pos_x, particles.pos_y);
+}
+
+//! \brief applies repulsion and attraction between the particles to \p count particles starting at \p first
+//! \brief disjoint ranges can interact concurrently, but must all finish before any of them is simulated
+//! \param first
+//! \param count
+//! \param dt time step
+void ParticleSystem::interact(std::size_t first, std::size_t count, float dt)
+{
+    if (m_grid.size() != m_particles.size())
+    {
+        return;
+    }
+    particle_interactions::applyPairForces(m_particles.spans(), first, count, m_grid, m_pair_forces, dt);
+}
+
+//! \brief runs the built-in kernels and the updater on \p count particles starting at \p first
+//! \brief disjoint ranges can be simulated concurrently (see ParticleWorld)
+//! \param first
+//! \param count
+//! \param dt time step
+void ParticleSystem::simulate(std::size_t first, std::size_t count, float dt)
+{
+    auto particles = m_particles.spans().subspan(first, count);
+    particle_kernels::age(particles, dt);
+    if (m_integrates)
+    {
+        particle_kernels::integrateEuler(particles, dt);
+    }
+    particle_interactions::collideWithRects(particles, m_colliders, m_restitution);
+    if (m_interpolates)
+    {
+        particle_kernels::interpolateColors(particles, m_init_color, m_final_color);
+    }
+    if (m_updater)
+    {
+        m_updater(particles, dt);
+    }
+}
+
+//! \brief destroys particles that lived longer than their life time
+void ParticleSystem::removeDeadParticles()
+{
+    m_particles.removeDead();
+}
+
+//! \brief creates one particle per each elapsed spawn period (as long as there is space for it)
+//! \param dt time step
+void ParticleSystem::spawnParticles(float dt)
+{
+    m_spawn_timer += dt * m_spawn_scale;
+    if (m_spawn_timer < m_spawn_period)
+    {
+        return;
+    }
+    const float elapsed_periods = std::floor(m_spawn_timer / m_spawn_period);
+    m_spawn_timer -= elapsed_periods * m_spawn_period;
+
+    //! periods which elapsed while the emitter was full are lost
+    std::size_t free_count = m_particles.capacity() - m_particles.size();
+    if (!m_repeats)
+    {
+        free_count = std::min(free_count, m_particles.capacity() - std::min(m_spawned_count, m_particles.capacity()));
+    }
+    const auto spawn_count = static_cast<std::size_t>(std::min(elapsed_periods, static_cast<float>(free_count)));
+    for (std::size_t i = 0; i < spawn_count; ++i)
+    {
+        Particle particle;
+        if (m_emitter)
+        {
+            particle = m_emitter(m_spawn_pos, m_rng);
+        }
+        else
+        {
+            particle.pos = m_spawn_pos;
+            particle.life_time = m_lifetime;
+        }
+        if (!m_particles.push(particle))
+        {
+            break;
+        }
+        m_spawned_count++;
+    }
+}
+
+//! \brief writes \p count particles starting at \p first into \p instances
+//! \param instances   must have space for \p count instances
+//! \param first
+//! \param count
+void ParticleSystem::fillInstances(ParticleInstance *instances, std::size_t first, std::size_t count)
+{
+    auto particles = m_particles.spans().subspan(first, count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto &instance = instances[i];
+        instance.pos = {particles.pos_x[i], particles.pos_y[i]};
+        instance.scale = {particles.scale_x[i] / 2.f, particles.scale_y[i] / 2.f};
+        instance.angle = particles.angle[i];
+        instance.color = {particles.color_r[i], particles.color_g[i], particles.color_b[i], particles.color_a[i]};
+    }
+}
+
+//! \brief puts instances of all particles (written by fillInstances in storage order) into the draw order
+//! \param instances   must hold size() instances
+void ParticleSystem::sortInstances(ParticleInstance *instances)
+{
+    m_sorter.sort(instances, m_particles.size(), m_particles.spans().time.data(), m_order, m_blending);
+}
+
+//! \brief Draws particles into \p canvas as one instanced batch, sorted by the set order
+//! \param canvas target to draw into
+void ParticleSystem::draw(Renderer &canvas)
+{
+    m_instances.resize(m_particles.size());
+    fillInstances(m_instances.data(), 0, m_instances.size());
+    m_sorter.sort(m_instances, m_particles.spans().time.data(), m_order, m_blending);
+    thinOutInstances(m_instances, m_draw_fraction);
+    canvas.drawInstances(m_instances, m_shader_id, {0, 0}, getBlendParams(m_blending));
+}
+
+void ParticleSystem::setSpawnPos(utils::Vector2f pos)
+{
+    m_spawn_pos = pos;
+}
+
+utils::Vector2f ParticleSystem::getSpawnPos() const
+{
+    return m_spawn_pos;
+}
+
+void ParticleSystem::setInitColor(Color color)
+{
+    m_init_color = color;
+}
+
+void ParticleSystem::setFinalColor(Color color)
+{
+    m_final_color = color;
+}
+
+//! \brief sets life time of particles created without an emitter
+void ParticleSystem::setLifetime(float lifetime)
+{
+    m_lifetime = lifetime;
+}
+
+void ParticleSystem::setRepeat(bool repeats)
+{
+    m_repeats = repeats;
+}
+
+bool ParticleSystem::getRepeat() const
+{
+    return m_repeats;
+}
+
+//! \brief sets time between two spawns, periods <= 0 are ignored
+void ParticleSystem::setPeriod(float period)
+{
+    if (period > 0.f)
+    {
+        m_spawn_period = period;
+    }
+}
+
+float ParticleSystem::getPeriod() const
+{
+    return m_spawn_period;
+}
+
+//! \brief sets function called once per update with views of all live particles (after the built-in kernels)
+//! \brief inside a ParticleWorld it may get just a chunk of them and run on a worker thread
+void ParticleSystem::setUpdater(Updater new_updater)
+{
+    m_updater = std::move(new_updater);
+}
+
+//! \brief sets function creating new particles at the spawn position
+void ParticleSystem::setEmitter(Emitter new_emitter)
+{
+    if (!new_emitter)
+    {
+        m_emitter = nullptr;
+        return;
+    }
+    m_emitter = [new_emitter = std::move(new_emitter)](utils::Vector2f spawn_pos, utils::Rng &)
+    { return new_emitter(spawn_pos); };
+}
+
+//! \brief sets emitter which takes random numbers from the generator of this emitter (see setSeed)
+void ParticleSystem::setEmitter(SeededEmitter new_emitter)
+{
+    m_emitter = std::move(new_emitter);
+}
+
+//! \brief restarts the random generator of the emitter, the same seed gives the same particles
+void ParticleSystem::setSeed(std::uint64_t seed)
+{
+    m_rng.seed(seed);
+}
+
+utils::Rng &ParticleSystem::getRng()
+{
+    return m_rng;
+}
+
+//! \brief turns the built-in Euler integration of velocities and positions on or off
+void ParticleSystem::setEulerIntegration(bool integrates)
+{
+    m_integrates = integrates;
+}
+
+//! \brief turns the built-in interpolation from m_init_color to m_final_color on or off
+void ParticleSystem::setColorInterpolation(bool interpolates)
+{
+    m_interpolates = interpolates;
+}
+
+//! \brief the shader gets ParticleInstance attributes (see vertex_particle_code in CommonShaders.inl)
+void ParticleSystem::setShader(const std::string &shader_id)
+{
+    m_shader_id = shader_id;
+}
+
+//! \brief multiplies the spawn rate by \p scale (0 stops spawning), used by ParticleBudget
+void ParticleSystem::setSpawnScale(float scale)
+{
+    m_spawn_scale = std::max(scale, 0.f);
+}
+
+//! \brief draws only \p fraction of the particles (spread evenly over them), used by ParticleBudget
+void ParticleSystem::setDrawFraction(float fraction)
+{
+    m_draw_fraction = std::clamp(fraction, 0.f, 1.f);
+}
+
+float ParticleSystem::getDrawFraction() const
+{
+    return m_draw_fraction;
+}
+
+//! \returns number of particles spawned during the time step \p dt without the spawn scale
+float ParticleSystem::getExpectedSpawnCount(float dt) const
+{
+    if (!m_repeats && m_spawned_count >= m_particles.capacity())
+    {
+        return 0.f;
+    }
+    return dt / m_spawn_period;
+}
+
+//! \returns box around the spawn position and all live particles (with their size)
+Rectf ParticleSystem::getBounds()
+{
+    auto particles = m_particles.spans();
+    utils::Vector2f min = m_spawn_pos;
+    utils::Vector2f max = m_spawn_pos;
+    for (std::size_t i = 0; i < particles.size(); ++i)
+    {
+        auto half_size = std::max(particles.scale_x[i], particles.scale_y[i]) / 2.f;
+        min.x = std::min(min.x, particles.pos_x[i] - half_size);
+        min.y = std::min(min.y, particles.pos_y[i] - half_size);
+        max.x = std::max(max.x, particles.pos_x[i] + half_size);
+        max.y = std::max(max.y, particles.pos_y[i] + half_size);
+    }
+    return {min.x, min.y, max.x - min.x, max.y - min.y};
+}
+
+std::size_t ParticleSystem::size() const
+{
+    return m_particles.size();
+}
+
+std::size_t ParticleSystem::capacity() const
+{
+    return m_particles.capacity();
+}
+
+ParticleArrays &ParticleSystem::getParticles()
+{
+    return m_particles;
+}
+
+//! \brief sets the order in which particles are drawn (storage order by default)
+void ParticleSystem::setOrder(ParticleOrder order)
+{
+    m_order = order;
+}
+
+ParticleOrder ParticleSystem::getOrder() const
+{
+    return m_order;
+}
+
+//! \brief sets how particles are blended, additive particles are never sorted
+void ParticleSystem::setBlending(ParticleBlending blending)
+{
+    m_blending = blending;
+}
+
+ParticleBlending ParticleSystem::getBlending() const
+{
+    return m_blending;
+}
+
+//! \brief particles closer than \p radius push each other away
+//! \param strength    acceleration between two touching particles, it falls linearly to zero at \p radius
+//! \param radius
+void ParticleSystem::setRepulsion(float strength, float radius)
+{
+    m_pair_forces.repulsion = strength;
+    m_pair_forces.repulsion_radius = radius;
+}
+
+//! \brief particles closer than \p radius pull each other together
+//! \param strength    acceleration between two touching particles, it falls linearly to zero at \p radius
+//! \param radius
+void ParticleSystem::setAttraction(float strength, float radius)
+{
+    m_pair_forces.attraction = strength;
+    m_pair_forces.attraction_radius = radius;
+}
+
+//! \brief particles bounce off the \p collider
+void ParticleSystem::addCollider(Rectf collider)
+{
+    m_colliders.push_back(collider);
+}
+
+void ParticleSystem::clearColliders()
+{
+    m_colliders.clear();
+}
+
+//! \brief sets part of the velocity kept after bouncing off a collider
+void ParticleSystem::setRestitution(float restitution)
+{
+    m_restitution = restitution;
+}
+
+//! \brief builds the grid every update with cells of \p cell_size, so that updaters can query neighbours
+//! \brief with 0, the grid is built only when pair forces are set, with cells as big as their radius
+void ParticleSystem::setGridCellSize(float cell_size)
+{
+    m_grid_cell_size = cell_size;
+}
+
+//! \returns grid of the particle positions from the start of the last update
+//! \brief its indices refer to the arrays of getParticles(), not to the spans passed to the updater
+const utils::SpatialGrid &ParticleSystem::getGrid() const
+{
+    return m_grid;
+}
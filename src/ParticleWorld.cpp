@@ -0,0 +1,173 @@
+#include "ParticleWorld.h"
+
+#include <algorithm>
+#include <numeric>
+
+//! \param n_threads    number of threads updating the emitters (including the one calling update)
+ParticleWorld::ParticleWorld(std::size_t n_threads)
+    : m_jobs(n_threads)
+{
+}
+
+//! \brief creates a new emitter owned by the world
+//! \param n_max_particles  maximum number of particles of the emitter
+//! \returns the new emitter, the reference is valid until the emitter is removed
+ParticleSystem &ParticleWorld::addEmitter(int n_max_particles)
+{
+    m_emitters.push_back(std::make_unique<ParticleSystem>(n_max_particles));
+    return *m_emitters.back();
+}
+
+void ParticleWorld::removeEmitter(const ParticleSystem &emitter)
+{
+    std::erase_if(m_emitters, [&emitter](const auto &p_emitter)
+                  { return p_emitter.get() == &emitter; });
+}
+
+void ParticleWorld::clear()
+{
+    m_emitters.clear();
+    m_instances.clear();
+    m_blend_groups.clear();
+}
+
+std::size_t ParticleWorld::getEmittersCount() const
+{
+    return m_emitters.size();
+}
+
+ParticleSystem &ParticleWorld::getEmitter(std::size_t index)
+{
+    return *m_emitters.at(index);
+}
+
+//! \returns number of live particles in all emitters
+std::size_t ParticleWorld::getParticlesCount() const
+{
+    std::size_t count = 0;
+    for (auto &emitter : m_emitters)
+    {
+        count += emitter->size();
+    }
+    return count;
+}
+
+std::size_t ParticleWorld::getThreadsCount() const
+{
+    return m_jobs.getThreadsCount();
+}
+
+//! \brief splits live particles of all emitters into chunks of at most m_chunk_size particles
+//! \brief and finds where the instances of each emitter start, emitters with the same blending are put next to each other
+void ParticleWorld::makeChunks()
+{
+    m_chunks.clear();
+    for (std::size_t emitter_index = 0; emitter_index < m_emitters.size(); ++emitter_index)
+    {
+        auto size = m_emitters[emitter_index]->size();
+        for (std::size_t first = 0; first < size; first += m_chunk_size)
+        {
+            m_chunks.push_back({emitter_index, first, std::min(m_chunk_size, size - first)});
+        }
+    }
+
+    m_draw_order.resize(m_emitters.size());
+    std::iota(m_draw_order.begin(), m_draw_order.end(), 0);
+    std::stable_sort(m_draw_order.begin(), m_draw_order.end(), [this](std::size_t a, std::size_t b)
+                     { return m_emitters[a]->getBlending() < m_emitters[b]->getBlending(); });
+
+    m_instance_offsets.resize(m_emitters.size());
+    std::size_t instances_count = 0;
+    for (auto emitter_index : m_draw_order)
+    {
+        m_instance_offsets[emitter_index] = instances_count;
+        instances_count += m_emitters[emitter_index]->size();
+    }
+    m_instances.resize(instances_count);
+}
+
+//! \brief spawns, simulates and removes dead particles of all emitters, then gathers their instances
+//! \param dt time step
+void ParticleWorld::update(float dt)
+{
+    m_jobs.parallelFor(m_emitters.size(), [this, dt](std::size_t emitter_index)
+                       {
+        m_emitters[emitter_index]->spawnParticles(dt);
+        m_emitters[emitter_index]->buildGrid(); });
+
+    //! interactions read positions of the whole emitter, so they all finish before any chunk moves
+    makeChunks();
+    m_jobs.parallelFor(m_chunks.size(), [this, dt](std::size_t chunk_index)
+                       {
+        auto &chunk = m_chunks[chunk_index];
+        m_emitters[chunk.emitter_index]->interact(chunk.first, chunk.count, dt); });
+
+    m_jobs.parallelFor(m_chunks.size(), [this, dt](std::size_t chunk_index)
+                       {
+        auto &chunk = m_chunks[chunk_index];
+        m_emitters[chunk.emitter_index]->simulate(chunk.first, chunk.count, dt); });
+
+    m_jobs.parallelFor(m_emitters.size(), [this](std::size_t emitter_index)
+                       { m_emitters[emitter_index]->removeDeadParticles(); });
+
+    //! every chunk writes its own part of m_instances
+    makeChunks();
+    m_jobs.parallelFor(m_chunks.size(), [this](std::size_t chunk_index)
+                       {
+        auto &chunk = m_chunks[chunk_index];
+        auto *instances = m_instances.data() + m_instance_offsets[chunk.emitter_index] + chunk.first;
+        m_emitters[chunk.emitter_index]->fillInstances(instances, chunk.first, chunk.count); });
+
+    m_drawn_counts.resize(m_emitters.size());
+    m_jobs.parallelFor(m_emitters.size(), [this](std::size_t emitter_index)
+                       {
+        auto &emitter = *m_emitters[emitter_index];
+        auto *instances = m_instances.data() + m_instance_offsets[emitter_index];
+        emitter.sortInstances(instances);
+        m_drawn_counts[emitter_index] = thinOutInstances(instances, emitter.size(), emitter.getDrawFraction()); });
+
+    compactInstances();
+}
+
+//! \brief moves the drawn instances of all emitters together, so that no gaps are left after thinning,
+//! \brief and finds the ranges drawn with the same blending. Emitters keep their order, so every range only moves to the front
+void ParticleWorld::compactInstances()
+{
+    m_blend_groups.clear();
+    std::size_t instances_count = 0;
+    for (auto emitter_index : m_draw_order)
+    {
+        auto blending = m_emitters[emitter_index]->getBlending();
+        if (m_blend_groups.empty() || m_blend_groups.back().blending != blending)
+        {
+            m_blend_groups.push_back({blending, instances_count, 0});
+        }
+        auto *instances = m_instances.data() + m_instance_offsets[emitter_index];
+        std::copy(instances, instances + m_drawn_counts[emitter_index], m_instances.data() + instances_count);
+        m_instance_offsets[emitter_index] = instances_count;
+        instances_count += m_drawn_counts[emitter_index];
+        m_blend_groups.back().count = instances_count - m_blend_groups.back().first;
+    }
+    m_instances.resize(instances_count);
+}
+
+//! \brief draws particles of all emitters as one instanced batch per blending
+//! \param canvas
+void ParticleWorld::draw(Renderer &canvas)
+{
+    for (auto &group : m_blend_groups)
+    {
+        canvas.drawInstances(m_instances.data() + group.first, group.count, m_shader_id, {0, 0}, getBlendParams(group.blending));
+    }
+}
+
+//! \brief sets maximum number of particles simulated by one job
+void ParticleWorld::setChunkSize(std::size_t chunk_size)
+{
+    m_chunk_size = std::max<std::size_t>(chunk_size, 1);
+}
+
+void ParticleWorld::setShader(const std::string &shader_id)
+{
+    m_shader_id = shader_id;
+}
@@ -3,16 +3,10 @@
 #include "Utils/RandomTools.h"
 #include "Renderer.h"
 
-Particle::Particle(utils::Vector2f init_pos, utils::Vector2f init_vel, utils::Vector2f acc, utils::Vector2f scale,
-                   Color color, float life_time)
-    : pos(init_pos), vel(init_vel), acc(acc), scale(scale), color(color), life_time(life_time)
-{
-}
-
 //! \brief constructs from maximum number of particles
 //! \param n_max_particles maximum number of particles
 Particles::Particles(int n_max_particles)
-    : m_particle_pool(n_max_particles)
+    : m_rng(makeEmitterRng()), m_particle_pool(n_max_particles)
 {
 }
 
@@ -38,7 +32,7 @@ int Particles::getPeriod() const
 void Particles::update(float dt)
 {
 
-    m_spawn_timer += dt;;
+    m_spawn_timer += dt * m_spawn_scale;
     if (m_spawn_timer >= m_spawn_period)
     {
         m_spawn_timer = 0;
@@ -71,7 +65,7 @@ void Particles::update(float dt)
 //! \brief creates new particle if there is space in particle pool
 void Particles::createParticle()
 {
-    auto new_particle = m_emitter(m_spawn_pos);
+    auto new_particle = m_emitter(m_spawn_pos, m_rng);
     m_particle_pool.insert(new_particle);
     n_spawned++;
 }
@@ -80,20 +74,8 @@ void Particles::createParticle()
 //! \brief and frees space in particle pool
 void Particles::destroyDeadParticles()
 {
-    auto &particles = m_particle_pool.getData();
-    std::vector<int> to_destroy;
-    for (size_t p_ind = 0; p_ind < m_particle_pool.size(); ++p_ind)
-    {
-        auto &particle = particles[p_ind];
-        if (particle.time > particle.life_time)
-        {
-            to_destroy.push_back(m_particle_pool.getEntityInd(p_ind));
-        }
-    }
-    for (auto part_ind : to_destroy)
-    {
-        m_particle_pool.removeByEntityInd(part_ind);
-    }
+    m_particle_pool.removeIf([](const Particle &particle)
+                             { return particle.time > particle.life_time; });
 }
 
 Color static interpolate(Color start, Color end, float lambda)
@@ -116,27 +98,32 @@ void Particles::integrate(float dt)
 }
 
 //! \brief Draws particles into \p canvas
+//! \brief all particles go into one instanced batch, quads are made in the vertex shader
 //! \brief \param canvas target to draw into
 void Particles::draw(Renderer &canvas)
 {
     auto &particles = m_particle_pool.getData();
     auto n_particles = m_particle_pool.size();
+    if (n_particles == 0)
+    {
+        return;
+    }
 
-    auto min_it = std::min_element(particles.begin(), particles.begin() + n_particles, [](auto &p1, auto &p2)
-                                   { return p1.time < p2.time; });
-    //! we draw from the youngest to the oldest
-    int youngest_particle_ind = min_it - particles.begin();
-    RectangleSimple rect;
+    m_instances.resize(n_particles);
+    m_ages.resize(n_particles);
     for (size_t i = 0; i < n_particles; ++i)
     {
-        int p_ind = (youngest_particle_ind + i) % n_particles;
-        auto &particle = particles.at(p_ind);
-        rect.setPosition(particle.pos.x, particle.pos.y);
-        rect.setRotation(particle.angle);
-        rect.setScale(particle.scale.x, particle.scale.y);
-        rect.m_color = particle.color;
-        canvas.drawRectangle(rect, m_shader_id);
+        auto &particle = particles[i];
+        auto &instance = m_instances[i];
+        instance.pos = particle.pos;
+        instance.scale = particle.scale / 2.f; //! particle scale is the whole size of the quad
+        instance.angle = particle.angle;
+        instance.color = particle.color;
+        m_ages[i] = particle.time;
     }
+    m_sorter.sort(m_instances, m_ages.data(), m_order, m_blending);
+    thinOutInstances(m_instances, m_draw_fraction);
+    canvas.drawInstances(m_instances, m_shader_id, {0, 0}, getBlendParams(m_blending));
 }
 
 void Particles::setUpdater(std::function<void(Particle &, float)> new_updater)
@@ -149,10 +136,28 @@ void Particles::setUpdaterFull(std::function<void(std::vector<Particle> &, int,
 }
 
 void Particles::setEmitter(std::function<Particle(utils::Vector2f)> new_emitter)
+{
+    m_emitter = [new_emitter](utils::Vector2f spawn_pos, utils::Rng &)
+    { return new_emitter(spawn_pos); };
+}
+
+//! \brief sets emitter which takes random numbers from the generator of this object (see setSeed)
+void Particles::setEmitter(std::function<Particle(utils::Vector2f, utils::Rng &)> new_emitter)
 {
     m_emitter = new_emitter;
 }
 
+//! \brief restarts the random generator of the emitter, the same seed gives the same particles
+void Particles::setSeed(std::uint64_t seed)
+{
+    m_rng.seed(seed);
+}
+
+utils::Rng &Particles::getRng()
+{
+    return m_rng;
+}
+
 void Particles::setInitColor(Color color)
 {
     m_init_color = color;
@@ -177,40 +182,124 @@ bool Particles::getRepeat() const
     return m_repeats;
 }
 
+//! \brief the shader gets ParticleInstance attributes (see vertex_particle_code in CommonShaders.inl)
 void Particles::setShader(const std::string &shader_id)
 {
     m_shader_id = shader_id;
 }
 
+//! \brief sets the order in which particles are drawn (by age by default)
+void Particles::setOrder(ParticleOrder order)
+{
+    m_order = order;
+}
+
+ParticleOrder Particles::getOrder() const
+{
+    return m_order;
+}
+
+//! \brief sets how particles are blended, additive particles are never sorted
+void Particles::setBlending(ParticleBlending blending)
+{
+    m_blending = blending;
+}
+
+ParticleBlending Particles::getBlending() const
+{
+    return m_blending;
+}
+
+//! \brief multiplies the spawn rate by \p scale (0 stops spawning), used by ParticleBudget
+void Particles::setSpawnScale(float scale)
+{
+    m_spawn_scale = std::max(scale, 0.f);
+}
+
+//! \brief draws only \p fraction of the particles (spread evenly over them), used by ParticleBudget
+void Particles::setDrawFraction(float fraction)
+{
+    m_draw_fraction = std::clamp(fraction, 0.f, 1.f);
+}
+
+//! \returns number of particles spawned during the time step \p dt without the spawn scale
+//! \brief at most one particle is spawned per update
+float Particles::getExpectedSpawnCount(float dt) const
+{
+    if (!m_repeats && n_spawned >= m_particle_pool.capacity())
+    {
+        return 0.f;
+    }
+    if (m_spawn_period <= dt)
+    {
+        return 1.f;
+    }
+    return dt / m_spawn_period;
+}
+
+//! \returns number of live particles
+std::size_t Particles::size() const
+{
+    return m_particle_pool.size();
+}
+
+//! \returns box around the spawn position and all live particles (with their size)
+Rectf Particles::getBounds() const
+{
+    auto &particles = m_particle_pool.getData();
+    utils::Vector2f min = m_spawn_pos;
+    utils::Vector2f max = m_spawn_pos;
+    for (std::size_t i = 0; i < m_particle_pool.size(); ++i)
+    {
+        auto &particle = particles[i];
+        auto half_size = std::max(particle.scale.x, particle.scale.y) / 2.f;
+        min.x = std::min(min.x, particle.pos.x - half_size);
+        min.y = std::min(min.y, particle.pos.y - half_size);
+        max.x = std::max(max.x, particle.pos.x + half_size);
+        max.y = std::max(max.y, particle.pos.y + half_size);
+    }
+    return {min.x, min.y, max.x - min.x, max.y - min.y};
+}
+
 TexturedParticles::TexturedParticles(int n_parts)
     : Particles(n_parts)
 {
+    m_shader_id = "ParticleTextured";
 }
 
 TexturedParticles::TexturedParticles(Texture &texture, int n_parts)
     : Particles(n_parts), m_texture(&texture) 
 {
+    m_shader_id = "ParticleTextured";
 }
 
+//! \brief Draws particles with the texture stretched over each of them (particle colors are not used)
+//! \param renderer target to draw into
 void TexturedParticles::draw(Renderer &renderer)
 {
+    if (!m_texture)
+    {
+        return;
+    }
 
     auto &particles = m_particle_pool.getData();
     auto n_particles = m_particle_pool.size();
 
-    // utils::Vector2f texture_size = asFloat(m_texture->getSize());
-    Sprite sprite(*m_texture);
-
+    m_instances.resize(n_particles);
+    m_ages.resize(n_particles);
     for (size_t p_ind = 0; p_ind < n_particles; ++p_ind)
     {
         auto &particle = particles[p_ind];
-
-        sprite.setPosition(particle.pos.x, particle.pos.y);
-        sprite.setRotation(particle.angle);
-        sprite.setScale(particle.scale.x, particle.scale.y);
-
-        renderer.drawSprite(sprite);
+        auto &instance = m_instances[p_ind];
+        instance.pos = particle.pos;
+        instance.scale = particle.scale;
+        instance.angle = particle.angle;
+        instance.color = {1, 1, 1, 1};
+        m_ages[p_ind] = particle.time;
     }
+    m_sorter.sort(m_instances, m_ages.data(), m_order, m_blending);
+    thinOutInstances(m_instances, m_draw_fraction);
+    renderer.drawInstances(m_instances, m_shader_id, {m_texture->getHandle(), 0}, getBlendParams(m_blending));
 }
 
 void Particles::setRepeat(bool repeats)
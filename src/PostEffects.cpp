@@ -36,15 +36,26 @@ void Bloom::process(Texture &source, Renderer &target)
     setBlendParams({bf::One, bf::OneMinusSrcAlpha, bf::One, bf::OneMinusSrcAlpha});
     m_screen_sprite.draw(target.getTarget(), m_combine_pass, source, m_bloom_pixels2.getTexture());
 }
+//! \brief bloom passes always sample their inputs at most 2x minified with their own filters, so mipmaps would be wasted
+static TextureOptions withoutMipmaps(TextureOptions options)
+{
+    options.mipmap_generation = MipmapGeneration::None;
+    if (options.min_param != TexMappingParam::Nearest)
+    {
+        options.min_param = TexMappingParam::Linear;
+    }
+    return options;
+}
+
 BloomPhysical::BloomPhysical(int width, int height, int mip_count, int gauss_pass_count, TextureOptions options, std::string final_shader)
-    : m_options(options),
-      m_bright_pixels(width, height, options),
+    : m_options(withoutMipmaps(options)),
+      m_bright_pixels(width, height, m_options),
       m_brightness_pass(std::string{vertex_sprite_code_direct}, std::string{fragment_brightness_code}),
       m_downsample_pass(std::string{vertex_sprite_code_direct}, std::string{fragment_downsample13_code}),
       m_upsample_pass(std::string{vertex_sprite_code_direct}, std::string{fragment_upsample_blur_code}),
       m_mixer_pass(std::string{vertex_sprite_code_direct}, std::string{fragment_upsample_mix_code})
 {
-    initMips(mip_count, width, height, options);
+    initMips(mip_count, width, height, m_options);
     m_upsample_pass.setUniform("u_filter_radius", 0.001f);
     m_brightness_pass.setUniform("u_threshold", 0.f);
 }
@@ -180,7 +191,7 @@ BloomFinal::BloomFinal(int width, int height, int mip_count, int gauss_pass_coun
       m_gauss_pass_count(gauss_pass_count),
       m_brightness_threshold(brightness_threshold)
 {
-    initMips(mip_count, width, height, options);
+    initMips(mip_count, width, height, withoutMipmaps(options));
 }
 
 void BloomFinal::initMips(int n_levels, int width, int height, TextureOptions options)
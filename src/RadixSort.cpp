@@ -0,0 +1,106 @@
+#include "Utils/RadixSort.h"
+#include "Utils/Simd.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace utils
+{
+
+    //! \returns the smallest and the largest of \p count > 0 \p keys
+    static std::pair<float, float> findRange(const float *keys, std::size_t count)
+    {
+        using namespace simd;
+        std::size_t i = 0;
+        float min_key = keys[0];
+        float max_key = keys[0];
+        if (count >= FLOATS_WIDTH)
+        {
+            Floats mins = load(keys);
+            Floats maxs = mins;
+            for (; i + FLOATS_WIDTH <= count; i += FLOATS_WIDTH)
+            {
+                auto values = load(keys + i);
+                mins = min(mins, values);
+                maxs = max(maxs, values);
+            }
+            std::array<float, FLOATS_WIDTH> min_lanes;
+            std::array<float, FLOATS_WIDTH> max_lanes;
+            store(min_lanes.data(), mins);
+            store(max_lanes.data(), maxs);
+            min_key = *std::min_element(min_lanes.begin(), min_lanes.end());
+            max_key = *std::max_element(max_lanes.begin(), max_lanes.end());
+        }
+        for (; i < count; ++i)
+        {
+            min_key = std::min(min_key, keys[i]);
+            max_key = std::max(max_key, keys[i]);
+        }
+        return {min_key, max_key};
+    }
+
+    //! \brief sorts indices of \p keys by the keys, equal keys keep their original order
+    //! \param keys
+    //! \param count    number of keys
+    //! \param descending   if true the largest key goes first
+    //! \returns indices into \p keys in the sorted order, valid until the next call
+    const std::vector<std::uint32_t> &RadixSorter::sort(const float *keys, std::size_t count, bool descending)
+    {
+        m_order.resize(count);
+        if (count == 0)
+        {
+            return m_order;
+        }
+        m_keys.resize(count);
+        m_scratch.resize(count);
+
+        //! keys are mapped linearly onto the whole 16-bit range, so that no precision is wasted
+        //! both histograms are made in the same pass
+        auto [min_key, max_key] = findRange(keys, count);
+        const float range = max_key - min_key;
+        const float scale = range > 0.f ? 65535.f / range : 0.f;
+        const std::uint16_t flip = descending ? 0xFFFF : 0;
+        std::array<std::uint32_t, 256> low_offsets = {};
+        std::array<std::uint32_t, 256> high_offsets = {};
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto key = static_cast<std::uint16_t>(static_cast<std::uint16_t>((keys[i] - min_key) * scale) ^ flip);
+            m_keys[i] = key;
+            low_offsets[key & 0xFF]++;
+            high_offsets[key >> 8]++;
+        }
+        std::uint32_t low_sum = 0;
+        std::uint32_t high_sum = 0;
+        for (std::size_t digit = 0; digit < 256; ++digit)
+        {
+            auto low_count = low_offsets[digit];
+            low_offsets[digit] = low_sum;
+            low_sum += low_count;
+
+            auto high_count = high_offsets[digit];
+            high_offsets[digit] = high_sum;
+            high_sum += high_count;
+        }
+
+        //! the low byte first, then the high byte, each pass is stable
+        //! the first pass stores the high byte next to the index, so the second one reads the keys sequentially
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            auto key = m_keys[i];
+            m_scratch[low_offsets[key & 0xFF]++] = (static_cast<std::uint64_t>(key >> 8) << 32) | i;
+        }
+        for (auto entry : m_scratch)
+        {
+            m_order[high_offsets[entry >> 32]++] = static_cast<std::uint32_t>(entry);
+        }
+        return m_order;
+    }
+
+    //! \returns indices of the keys from the last sort in the sorted order
+    const std::vector<std::uint32_t> &RadixSorter::getOrder() const
+    {
+        return m_order;
+    }
+
+} // namespace utils
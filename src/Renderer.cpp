@@ -7,11 +7,11 @@
 #include "Font.h"
 #include "Text.h"
 #include "Sprite.h"
+#include "ParticleInstance.h"
 #include "CommonShaders.inl"
 
 #include <chrono>
 #include <numbers>
-#include <codecvt>
 
 #include <SDL2/SDL_mouse.h>
 
@@ -25,13 +25,17 @@ Renderer::Renderer(RenderTarget &target)
     m_shaders.loadFromCode("VertexArrayDefault", vertex_vertexarray_code, fragment_fullpass_code);
     m_shaders.loadFromCode("SpriteDefault", vertex_sprite_code, fragment_fullpass_texture_code);
     m_shaders.loadFromCode("SpritePass", vertex_sprite_code, fragment_fullpass_texture_code_no_alpha);
+    m_shaders.loadFromCode("SpriteArrayDefault", vertex_sprite_array_code, fragment_sprite_array_code);
     m_shaders.loadFromCode("TextDefault", vertex_sprite_code, fragment_text_code);
     m_shaders.loadFromCode("TextDefault2", vertex_text_code, fragment_text2_code);
+    m_shaders.loadFromCode("ParticleDefault", vertex_particle_code, fragment_fullpass_code);
+    m_shaders.loadFromCode("ParticleTextured", vertex_particle_code, fragment_fullpass_texture_code);
 
     //! register Default Batch Types
     m_batches.registerBatch<utils::Vector2f, SpriteInstance>(makeSpriteBatch);
     m_batches.registerBatch<utils::Vector2f, TextInstance>(makeTextBatch);
     m_batches.registerBatch<Vertex, float>(makeVertexBatch);
+    registerDrawable<ParticleInstance>();
 
     m_view = getDefaultView();
 }
@@ -136,7 +140,8 @@ void Renderer::drawSprite(Sprite &sprite, const std::string &shader_id)
     if (checkShader(shader_id))
     {
         drawSpriteUnpacked(sprite.getPosition(), sprite.getScale(), sprite.getRotation(), sprite.m_color,
-                           sprite.m_tex_rect, sprite.m_tex_size, sprite.m_texture_handles, shader_id);
+                           sprite.m_tex_rect, sprite.m_tex_size, sprite.m_texture_handles,
+                           sprite.m_texture_target, sprite.m_texture_layer, shader_id);
     }
 }
 
@@ -147,45 +152,22 @@ void Renderer::drawText2(const Text &text, const std::string &shader_id)
         return;
     }
     auto &shader = m_shaders.get(shader_id);
-    const auto &string = text.getTextW();
     auto font = text.getFont();
     if (!font)
     {
         return;
     }
 
-    BatchConfig config({font->getTexture().getHandle(), font->getCharmapTexId()}, &shader);
-
-    TextInstance glyph;
-    utils::Vector2f text_scale = text.getScale();
-    auto center_pos = text.getPosition();
-    auto line_pos = center_pos;
-    utils::Vector2f glyph_pos = center_pos;
-    for (std::size_t glyph_ind = 0; glyph_ind < string.size(); ++glyph_ind)
+    //! the layout is cached in the text, so static texts are just copied into the batches
+    const auto &glyph_run = text.getGlyphRun();
+    for (auto &[page_handle, glyphs] : glyph_run.pages)
     {
-        auto character = font->m_characters.at(string.at(glyph_ind));
-        float width = character.size.x * text_scale.x;
-        float height = character.size.y * text_scale.y;
-        float dy = character.size.y - character.bearing.y;
-
-        glyph_pos.x = line_pos.x + character.bearing.x * text_scale.x + width / 2.f;
-        glyph_pos.y = line_pos.y + height / 2.f - dy * text_scale.y;
-
-        glyph.pos = glyph_pos;
-        glyph.scale = {width / 2.f, height / 2.f};
-        glyph.fill_color = text.getColor();
-        glyph.edge_color = text.m_edge_color;
-        glyph.glow_color = text.m_glow_color;
-        glyph.char_code = font->m_charcode2texcode.at(string.at(glyph_ind));
-
-        m_batches.pushInstance(glyph, config);
-        //! pushTextInstance(glyph);
-
-        line_pos.x += (character.advance >> 6) * text_scale.x;
+        BatchConfig config({page_handle, font->getCharmapTexId()}, &shader);
+        m_batches.pushInstances(glyphs, config);
     }
 
-    auto bounding_box = text.getBoundingBox();
-    line_pos = {bounding_box.pos_x, bounding_box.pos_y};
+    auto bounding_box = glyph_run.bounding_box;
+    utils::Vector2f line_pos = {bounding_box.pos_x, bounding_box.pos_y};
     utils::Vector2f text_size = {bounding_box.width, bounding_box.height};
     if (text.m_draw_bounding_box)
     {
@@ -207,7 +189,6 @@ void Renderer::drawText(const Text &text, const std::string &shader_id)
     {
         return;
     }
-    const auto &string = text.getTextW();
     auto font = text.getFont();
     if (!font)
     {
@@ -225,19 +206,20 @@ void Renderer::drawText(const Text &text, const std::string &shader_id)
         line_pos.y -= bb.height / 2.f;
         line_pos.y += depth;
     }
-    for (std::size_t glyph_ind = 0; glyph_ind < string.size(); ++glyph_ind)
+    for (auto &shaped_glyph : text.getGlyphRun().shaped_glyphs)
     {
-        auto character = font->m_characters.at(string.at(glyph_ind));
+        const auto &character = font->getCharacter(shaped_glyph.code);
         float width = character.size.x * text_scale.x;
         float height = character.size.y * text_scale.y;
         float dy = character.size.y - character.bearing.y;
 
         utils::Vector2f glyph_pos = {
-            line_pos.x + character.bearing.x * text_scale.x + width / 2.f,
-            line_pos.y + height / 2.f - dy * text_scale.y};
+            line_pos.x + (shaped_glyph.x_offset + character.bearing.x) * text_scale.x + width / 2.f,
+            line_pos.y + height / 2.f + (shaped_glyph.y_offset - dy) * text_scale.y};
 
+        glyph_sprite.m_texture_handles[0] = character.texture_id;
         glyph_sprite.m_tex_rect = {character.tex_coords.x, character.tex_coords.y,
-                                   character.size.x, character.size.y};
+                                   character.tex_size.x, character.tex_size.y};
 
         //! setPosition sets center of the sprite not the corner position. so we must correct for that
         glyph_sprite.setPosition(glyph_pos);
@@ -249,9 +231,10 @@ void Renderer::drawText(const Text &text, const std::string &shader_id)
         // drawLineBatched({glyph_pos.x + width/2.f, glyph_pos.y -height/2.f}, {glyph_pos.x + width/2.f, glyph_pos.y + height/2.f}, 0.5, {0, 1, 0, 1});
         // drawLineBatched({glyph_pos.x + width/2.f, glyph_pos.y +height/2.f}, {glyph_pos.x - width/2.f, glyph_pos.y + height/2.f}, 0.5, {0, 1, 0, 1});
         // drawLineBatched({glyph_pos.x - width/2.f, glyph_pos.y +height/2.f}, {glyph_pos.x - width/2.f, glyph_pos.y - height/2.f}, 0.5, {0, 1, 0, 1});
-        line_pos.x += (character.advance >> 6) * text_scale.x;
+        line_pos.x += shaped_glyph.x_advance * text_scale.x;
         drawSprite(glyph_sprite, shader_id);
     }
+    font->uploadPendingGlyphs();
 
     auto bounding_box = text.getBoundingBox();
     line_pos = {bounding_box.pos_x, bounding_box.pos_y};
@@ -272,10 +255,12 @@ void Renderer::drawText(const Text &text, const std::string &shader_id)
 //! \param angle rotation in radians
 //! \param color color as 4 0-255 unsigned chars
 //! \param tex_rect texture rectangle
+//! \param texture_target  Texture2DArray when the handles belong to ArrayTextures
+//! \param texture_layer   layer of the ArrayTexture (sent per instance)
 //! \param shader_id
-//! \param draw_type
 void Renderer::drawSpriteUnpacked(Vec2 center, Vec2 scale, float angle, ColorByte color, Rect<int> tex_rect,
                                   Vec2 texture_size, TextureArray &texture_handles,
+                                  TextureTarget texture_target, int texture_layer,
                                   const std::string &shader_id)
 {
     auto &shader = m_shaders.get(shader_id);
@@ -285,6 +270,7 @@ void Renderer::drawSpriteUnpacked(Vec2 center, Vec2 scale, float angle, ColorByt
     t.trans = center;
     t.scale = scale;
     t.color = color;
+    t.texture_layer = texture_layer;
 
     //! normalize the texture rectangle to be between [0,1] just as OpenGL likes it
     auto tex_size = texture_size;
@@ -295,7 +281,21 @@ void Renderer::drawSpriteUnpacked(Vec2 center, Vec2 scale, float angle, ColorByt
     t.tex_coords = {tex_rect_norm.pos_x, 1. - tex_rect_norm.pos_y};
     t.tex_size = {tex_rect_norm.width, tex_rect_norm.height};
 
+    //! lazily mipmapped textures need up to date mipmaps only when they are drawn smaller than they are
+    float pixels_per_unit_x = m_viewport.width * m_target.getSize().x / m_view.getSize().x;
+    float pixels_per_unit_y = m_viewport.height * m_target.getSize().y / m_view.getSize().y;
+    bool is_minified = 2.f * std::abs(scale.x) * pixels_per_unit_x < std::abs(tex_rect.width) ||
+                       2.f * std::abs(scale.y) * pixels_per_unit_y < std::abs(tex_rect.height);
+    if (is_minified && texture_target == TextureTarget::Texture2D)
+    {
+        for (auto handle : texture_handles)
+        {
+            requestMipmaps(handle);
+        }
+    }
+
     BatchConfig config(texture_handles, &shader);
+    config.texture_target = texture_target;
 
     m_batches.pushInstance(t, config);
 }
@@ -528,7 +528,7 @@ void Renderer::drawAllInto(RenderTarget &target)
                m_viewport.width * m_target.getSize().x,
                m_viewport.height * m_target.getSize().y);
 
-    m_batches.renderAll(m_view);
+    m_batches.renderAll(m_view, m_blend_factors);
 }
 
 //! \brief draws all the batched calls into a associated RenderTarget
@@ -0,0 +1,166 @@
+#include "Utils/Rng.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace utils
+{
+
+    //! \returns next number of the splitmix64 sequence, used only to spread the seed into the lane states
+    static std::uint64_t splitMix64(std::uint64_t &state)
+    {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    //! \returns float in [0, 1) made of the upper 24 bits of \p bits
+    static float toUnitFloat(std::uint32_t bits)
+    {
+        return static_cast<float>(bits >> 8) * (1.f / 16777216.f);
+    }
+
+    static std::uint32_t rotateLeft(std::uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    //! \param seed
+    //! \param stream   generators with the same seed but different streams give unrelated sequences
+    Rng::Rng(std::uint64_t seed, std::uint64_t stream)
+    {
+        this->seed(seed, stream);
+    }
+
+    //! \brief restarts the generator, afterwards it gives the same numbers as a new Rng(\p seed, \p stream)
+    void Rng::seed(std::uint64_t seed, std::uint64_t stream)
+    {
+        m_state = 0;
+        std::uint64_t stream_state = stream;
+        m_increment = (splitMix64(stream_state) << 1u) | 1u; //! all bits of the stream select the increment
+        next();
+        m_state += seed;
+        next();
+
+        std::uint64_t mix_state = seed ^ (stream * 0xda942042e4dd58b5ULL);
+        for (std::size_t lane = 0; lane < LANES; ++lane)
+        {
+            auto low = splitMix64(mix_state);
+            auto high = splitMix64(mix_state);
+            m_lanes0[lane] = static_cast<std::uint32_t>(low);
+            m_lanes1[lane] = static_cast<std::uint32_t>(low >> 32);
+            m_lanes2[lane] = static_cast<std::uint32_t>(high);
+            m_lanes3[lane] = static_cast<std::uint32_t>(high >> 32) | 1u; //! xoshiro state must not be all zeros
+        }
+        m_has_spare_gaussian = false;
+    }
+
+    //! \returns uniformly distributed 32 bits (PCG32 XSH RR)
+    std::uint32_t Rng::next()
+    {
+        auto old_state = m_state;
+        m_state = old_state * 6364136223846793005ULL + m_increment;
+        auto xorshifted = static_cast<std::uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+        auto rotation = static_cast<int>(old_state >> 59u);
+        return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+    }
+
+    //! \returns number from [0, 1)
+    float Rng::uniform()
+    {
+        return toUnitFloat(next());
+    }
+
+    //! \returns number from [\p min, \p max)
+    float Rng::uniform(float min, float max)
+    {
+        return min + uniform() * (max - min);
+    }
+
+    //! \returns integer from [\p min, \p max] (both included)
+    int Rng::uniformInt(int min, int max)
+    {
+        auto range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min) + 1;
+        return static_cast<int>(min + static_cast<std::int64_t>((next() * range) >> 32));
+    }
+
+    //! \returns normally distributed number (Box-Muller transform)
+    float Rng::gaussian(float mean, float stddev)
+    {
+        if (m_has_spare_gaussian)
+        {
+            m_has_spare_gaussian = false;
+            return mean + stddev * m_spare_gaussian;
+        }
+        float radius = std::sqrt(-2.f * std::log(1.f - uniform()));
+        float angle = 2.f * std::numbers::pi_v<float> * uniform();
+        m_spare_gaussian = radius * std::sin(angle);
+        m_has_spare_gaussian = true;
+        return mean + stddev * radius * std::cos(angle);
+    }
+
+    //! \returns uniformly distributed point inside the box with the upper left corner \p ul_corner
+    Vector2f Rng::inBox(Vector2f ul_corner, Vector2f box_size)
+    {
+        float x = uniform();
+        float y = uniform();
+        return {ul_corner.x + x * box_size.x, ul_corner.y + y * box_size.y};
+    }
+
+    //! \brief fills \p values with numbers from [\p min, \p max)
+    //! \brief much faster than calling uniform() for each value
+    void Rng::fillUniform(std::span<float> values, float min, float max)
+    {
+        const float range = max - min;
+        //! the lanes are copied into locals, so the compiler knows they do not alias \p values and vectorizes the loop
+        auto lanes0 = m_lanes0;
+        auto lanes1 = m_lanes1;
+        auto lanes2 = m_lanes2;
+        auto lanes3 = m_lanes3;
+        std::array<float, LANES> block;
+        for (std::size_t first = 0; first < values.size(); first += LANES)
+        {
+            for (std::size_t lane = 0; lane < LANES; ++lane)
+            {
+                //! xoshiro128+
+                auto result = lanes0[lane] + lanes3[lane];
+                auto t = lanes1[lane] << 9;
+                lanes2[lane] ^= lanes0[lane];
+                lanes3[lane] ^= lanes1[lane];
+                lanes1[lane] ^= lanes2[lane];
+                lanes0[lane] ^= lanes3[lane];
+                lanes2[lane] ^= t;
+                lanes3[lane] = rotateLeft(lanes3[lane], 11);
+                block[lane] = min + toUnitFloat(result) * range;
+            }
+            auto count = std::min(LANES, values.size() - first);
+            std::copy(block.begin(), block.begin() + count, values.begin() + first);
+        }
+        m_lanes0 = lanes0;
+        m_lanes1 = lanes1;
+        m_lanes2 = lanes2;
+        m_lanes3 = lanes3;
+    }
+
+    //! \brief fills \p values with normally distributed numbers
+    void Rng::fillGaussian(std::span<float> values, float mean, float stddev)
+    {
+        fillUniform(values);
+        //! Box-Muller turns each pair of uniform numbers into two normal ones
+        std::size_t i = 0;
+        for (; i + 2 <= values.size(); i += 2)
+        {
+            float radius = stddev * std::sqrt(-2.f * std::log(1.f - values[i]));
+            float angle = 2.f * std::numbers::pi_v<float> * values[i + 1];
+            values[i] = mean + radius * std::cos(angle);
+            values[i + 1] = mean + radius * std::sin(angle);
+        }
+        if (i < values.size())
+        {
+            values[i] = gaussian(mean, stddev);
+        }
+    }
+
+} // namespace utils
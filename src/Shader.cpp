@@ -28,6 +28,12 @@ std::istringstream loadFileToStream(std::string path)
     return std::istringstream{loadFileToString(path)};
 }
 
+//! \brief textures are bound to slots separately from the other uniforms
+static bool isSamplerType(const std::string &type_string)
+{
+    return type_string == "sampler2D" || type_string == "sampler2DArray";
+}
+
 //! \brief read a shader file in \p filename and extracts all uniforms (that are not textures!)
 //! \brief the uniform names-values pairs are stored in \p shader_data
 //! \param shader_data
@@ -44,7 +50,7 @@ void static extractUniformNamesFromCode(VariablesData &shader_data, const std::s
         } //! try only lines that have some words on them
         if (split_line[0] == "uniform")
         {
-            if (split_line[1] == "sampler2D") //! skip textures, we do them separately
+            if (isSamplerType(split_line[1])) //! skip textures, we do them separately
             {
                 continue;
             }
@@ -101,7 +107,7 @@ void static extractTextureNamesFromCode(VariablesData &shader_data, const std::s
         {
             continue;
         } //! try only lines that have some words on them
-        if (split_line[0] == "uniform" && split_line[1] == "sampler2D")
+        if (split_line[0] == "uniform" && isSamplerType(split_line[1]))
         {
 
             std::string texture_var_name = split_line[2];
@@ -140,7 +146,7 @@ void extractUniformNames(VariablesData &shader_data, const std::string &filename
         } //! try only lines that have some words on them
         if (split_line[0] == "uniform")
         {
-            if (split_line[1] == "sampler2D")
+            if (isSamplerType(split_line[1]))
             {
                 continue;
             }
@@ -183,7 +189,7 @@ void extractUniformNames(VariablesData &shader_data, const std::string &filename
         {
             continue;
         }
-        if (split_line[0] == "uniform" && split_line[1] == "sampler2D")
+        if (split_line[0] == "uniform" && isSamplerType(split_line[1]))
         {
 
             std::string texture_var_name = split_line[2];
@@ -486,6 +492,15 @@ bool Shader::loadFromCode(const std::string &vertex_code, const std::string &fra
     m_id = glCreateProgram();
     glAttachShader(m_id, vertex);
     glAttachShader(m_id, fragment);
+    if (!m_feedback_varyings.empty()) //! varyings must be given before linking
+    {
+        std::vector<const char *> varying_names;
+        for (auto &name : m_feedback_varyings)
+        {
+            varying_names.push_back(name.c_str());
+        }
+        glTransformFeedbackVaryings(m_id, varying_names.size(), varying_names.data(), GL_INTERLEAVED_ATTRIBS);
+    }
     glLinkProgram(m_id);
     // print linking errors if any
     glGetProgramiv(m_id, GL_LINK_STATUS, &success);
@@ -606,6 +621,14 @@ bool Shader::getReloadOnChange() const
     return m_reload_on_file_change;
 }
 
+//! \brief sets outputs of the vertex shader written into the transform feedback buffer (interleaved in the given order)
+//! \brief must be called before the shader is loaded
+//! \param varyings    names of the vertex shader outputs
+void Shader::setTransformFeedbackVaryings(std::vector<std::string> varyings)
+{
+    m_feedback_varyings = std::move(varyings);
+}
+
 VariablesData &Shader::getVariables()
 {
     return m_variables;
@@ -1,6 +1,7 @@
 #include "ShaderHolder.h"
 
 #include "Shader.h"
+#include "AssetPack.h"
 
 //! \brief sets base path for searching shaders when loading
 //! \param directory    path to a directory
@@ -135,6 +136,23 @@ bool ShaderHolder::loadFromCode(const std::string &name,
     return true;
 }
 
+//! \brief loads shader with id \p name from entries of an opened asset \p pack
+//! \brief the code is compiled straight from the mapped pack without touching the file system
+//! \param name
+//! \param pack
+//! \param vertex_entry    name of the vertex shader inside the pack
+//! \param fragment_entry  name of the fragment shader inside the pack
+//! \returns true if succesfully added
+bool ShaderHolder::loadFromPack(const std::string &name, const AssetPack &pack,
+                                const std::string &vertex_entry, const std::string &fragment_entry)
+{
+    if (!pack.contains(vertex_entry) || !pack.contains(fragment_entry))
+    {
+        return false;
+    }
+    return loadFromCode(name, std::string{pack.getString(vertex_entry)}, std::string{pack.getString(fragment_entry)});
+}
+
 //! \brief forces reload of all the shaders in the container
 void ShaderHolder::refresh()
 {
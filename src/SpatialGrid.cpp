@@ -0,0 +1,104 @@
+#include "Utils/SpatialGrid.h"
+
+namespace utils
+{
+
+    //! \param cell_size    best about the radius of the queries, so that a query reads 3x3 cells
+    SpatialGrid::SpatialGrid(float cell_size)
+    {
+        setCellSize(cell_size);
+    }
+
+    //! \brief the cell size is used from the next build
+    void SpatialGrid::setCellSize(float cell_size)
+    {
+        m_cell_size = std::max(cell_size, 1e-6f);
+    }
+
+    float SpatialGrid::getCellSize() const
+    {
+        return m_cell_size;
+    }
+
+    //! \brief sorts the points into cells, \p xs and \p ys must have the same size
+    //! \brief at most about two cells per point are made, if the points are spread wider, the cells get bigger
+    //! \param xs   x coordinates of the points
+    //! \param ys   y coordinates of the points
+    void SpatialGrid::build(std::span<const float> xs, std::span<const float> ys)
+    {
+        const auto count = std::min(xs.size(), ys.size());
+        if (count == 0)
+        {
+            clear();
+            return;
+        }
+
+        auto [min_x, max_x] = std::minmax_element(xs.begin(), xs.begin() + count);
+        auto [min_y, max_y] = std::minmax_element(ys.begin(), ys.begin() + count);
+        m_min_x = *min_x;
+        m_min_y = *min_y;
+        const float width = *max_x - m_min_x;
+        const float height = *max_y - m_min_y;
+
+        float cell_size = m_cell_size;
+        const float max_cells_count = 2.f * count + 64.f;
+        const float cells_count = (width / cell_size + 1.f) * (height / cell_size + 1.f);
+        if (cells_count > max_cells_count)
+        {
+            cell_size *= std::sqrt(cells_count / max_cells_count);
+        }
+        m_inv_cell_size = 1.f / cell_size;
+        m_cells_x = static_cast<int>(width * m_inv_cell_size) + 1;
+        m_cells_y = static_cast<int>(height * m_inv_cell_size) + 1;
+
+        //! counting sort: count points per cell, make the counts into starts and put each point at its place
+        const auto n_cells = static_cast<std::size_t>(m_cells_x) * m_cells_y;
+        m_cell_starts.assign(n_cells + 1, 0);
+        m_point_cells.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto cell = static_cast<std::uint32_t>(cellY(ys[i]) * m_cells_x + cellX(xs[i]));
+            m_point_cells[i] = cell;
+            m_cell_starts[cell + 1]++;
+        }
+        for (std::size_t cell = 0; cell < n_cells; ++cell)
+        {
+            m_cell_starts[cell + 1] += m_cell_starts[cell];
+        }
+
+        m_indices.resize(count);
+        m_xs.resize(count);
+        m_ys.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto place = m_cell_starts[m_point_cells[i]]++;
+            m_indices[place] = static_cast<std::uint32_t>(i);
+            m_xs[place] = xs[i];
+            m_ys[place] = ys[i];
+        }
+        //! the placing moved each start to the end of its cell, which is the start of the next one
+        for (std::size_t cell = n_cells; cell > 0; --cell)
+        {
+            m_cell_starts[cell] = m_cell_starts[cell - 1];
+        }
+        m_cell_starts[0] = 0;
+    }
+
+    //! \brief removes all points
+    void SpatialGrid::clear()
+    {
+        m_cells_x = 0;
+        m_cells_y = 0;
+        m_cell_starts.clear();
+        m_indices.clear();
+        m_xs.clear();
+        m_ys.clear();
+    }
+
+    //! \returns number of points in the grid
+    std::size_t SpatialGrid::size() const
+    {
+        return m_indices.size();
+    }
+
+} // namespace utils
@@ -1,5 +1,6 @@
 #include "Sprite.h"
 #include "Texture.h"
+#include "ArrayTexture.h"
 
 Sprite::Sprite(const Texture &texture)
     : m_tex_rect(0, 0, (int)texture.getSize().x, (int)texture.getSize().y)
@@ -11,6 +12,8 @@ Sprite::Sprite(const Texture &texture)
 void Sprite::setTexture(GLuint tex_id, int slot)
 {
     m_texture_handles.at(slot) = tex_id;
+    m_texture_target = TextureTarget::Texture2D;
+    m_texture_layer = 0;
 }
 void Sprite::setTexture(const Texture &texture)
 {
@@ -20,6 +23,20 @@ void Sprite::setTexture(const Texture &texture)
 void Sprite::setTexture(int slot, const Texture &texture)
 {
     m_texture_handles.at(slot) = texture.getHandle();
+    m_texture_target = TextureTarget::Texture2D; //! the sprite might have used an ArrayTexture before
+    m_texture_layer = 0;
+    m_tex_rect = {0, 0, (int)texture.getSize().x, (int)texture.getSize().y};
+    m_tex_size = texture.getSize();
+}
+
+//! \brief uses the \p layer of the array \p texture, sprites sharing the texture can be drawn by a single draw call
+//! \param texture
+//! \param layer   index of the image in the \p texture
+void Sprite::setTexture(const ArrayTexture &texture, int layer)
+{
+    m_texture_handles = {texture.getHandle(), 0};
+    m_texture_target = TextureTarget::Texture2DArray;
+    m_texture_layer = layer;
     m_tex_rect = {0, 0, (int)texture.getSize().x, (int)texture.getSize().y};
     m_tex_size = texture.getSize();
 }
@@ -1,12 +1,13 @@
 #include "Text.h"
 #include "Renderer.h"
+#include "Utils/Utf8.h"
 
-#include <codecvt>
+#include <algorithm>
+#include <limits>
 
-Text::Text(std::string text)
+Text::Text(std::string_view text)
 {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-    m_text = conv.from_bytes(text);
+    setText(text);
 }
 const std::wstring &Text::getTextW() const
 {
@@ -16,22 +17,28 @@ const std::wstring &Text::getTextW() const
 void Text::setFont(Font *new_font)
 {
     m_font = new_font;
+    m_glyph_run_valid = false;
 }
 Font *Text::getFont() const
 {
     return m_font;
 }
 
-void Text::setText(const std::string &new_text)
+//! \brief sets the text from UTF-8, setting the same text again costs just a comparison
+void Text::setText(std::string_view new_text)
 {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-    m_text = conv.from_bytes(new_text);
+    if (new_text == m_text_utf8)
+    {
+        return;
+    }
+    m_text_utf8.assign(new_text);
+    utils::decodeUtf8(m_text_utf8, m_text);
+    m_glyph_run_valid = false;
 }
 
-std::string Text::getText() const
+const std::string &Text::getText() const
 {
-    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
-    return conv.to_bytes(m_text);
+    return m_text_utf8;
 }
 
 void Text::setColor(ColorByte new_color)
@@ -79,230 +86,505 @@ void Text::centerAround(const utils::Vector2f &center)
 }
 
 //! \returns calculates the width of the text;
-//! TODO: this should probably be kept as a parameter in the class
 float Text::getTextWidth() const
 {
-    if (!m_font)
+    return getGlyphRun().bounding_box.width;
+}
+
+float Text::getDepthUnderLine() const
+{
+    return getGlyphRun().depth_under_line;
+}
+
+Rect<float> Text::getBoundingBox() const
+{
+    return getGlyphRun().bounding_box;
+}
+
+//! \returns glyphs of the text laid out at its current position and scale
+//!  The layout is cached, it is recomputed only after the text, font, position, scale or colors changed
+const GlyphRun &Text::getGlyphRun() const
+{
+    ColorByte colors[3] = {m_color, m_edge_color, m_glow_color};
+    bool colors_changed = !std::equal(colors, colors + 3, m_run_colors);
+    if (!m_glyph_run_valid || colors_changed || !(m_run_scale == getScale()) ||
+        (m_font && m_run_font_generation != m_font->getGeneration()))
     {
-        return 0.f;
+        updateGlyphRun();
     }
-
-    float width = 0.f;
-    for (std::size_t glyph_ind = 0; glyph_ind < m_text.size(); ++glyph_ind)
+    else if (!(m_run_position == getPosition()))
     {
-        auto character = m_font->m_characters.at(m_text.at(glyph_ind));
-        width += (character.advance >> 6) * getScale().x;
+        translateGlyphRun(getPosition() - m_run_position);
     }
-    return width;
+    return m_glyph_run;
 }
 
-float Text::getDepthUnderLine() const
+//! \brief moves the cached glyphs by \p delta, a moved text does not need to be shaped again
+void Text::translateGlyphRun(utils::Vector2f delta) const
 {
-    if (m_text.empty())
+    m_run_position = getPosition();
+    for (auto &[page_handle, glyphs] : m_glyph_run.pages)
     {
-        return 0.f;
+        for (auto &glyph : glyphs)
+        {
+            glyph.pos += delta;
+        }
     }
+    m_glyph_run.bounding_box.pos_x += delta.x;
+    m_glyph_run.bounding_box.pos_y += delta.y;
+}
+
+//! \brief lays out all glyphs in a single pass over the text
+void Text::updateGlyphRun() const
+{
+    m_glyph_run_valid = true;
+    m_run_position = getPosition();
+    m_run_scale = getScale();
+    m_run_colors[0] = m_color;
+    m_run_colors[1] = m_edge_color;
+    m_run_colors[2] = m_glow_color;
+    m_glyph_run.pages.clear();
+    m_glyph_run.shaped_glyphs.clear();
+    m_glyph_run.bounding_box = {getPosition().x, getPosition().y, 0, 0};
+    m_glyph_run.depth_under_line = 0.f;
+    if (!m_font || m_text.empty())
+    {
+        return;
+    }
+    m_run_font_generation = m_font->getGeneration();
+
+    utils::Vector2f text_scale = getScale();
+    auto line_pos = getPosition();
+    float lowest_y = std::numeric_limits<float>::max();
+    float highest_top = std::numeric_limits<float>::lowest();
+    float highest_glyph_height = 0.f;
+
+    TextInstance glyph;
+    glyph.fill_color = m_color;
+    glyph.edge_color = m_edge_color;
+    glyph.glow_color = m_glow_color;
+    m_glyph_run.shaped_glyphs = m_font->shape(m_text);
+    for (auto &shaped_glyph : m_glyph_run.shaped_glyphs)
+    {
+        const auto &character = m_font->getCharacter(shaped_glyph.code);
+        float width = character.size.x * text_scale.x;
+        float height = character.size.y * text_scale.y;
+        float dy = character.size.y - character.bearing.y;
+
+        glyph.pos.x = line_pos.x + (shaped_glyph.x_offset + character.bearing.x) * text_scale.x + width / 2.f;
+        glyph.pos.y = line_pos.y + height / 2.f + (shaped_glyph.y_offset - dy) * text_scale.y;
+        glyph.scale = {width / 2.f, height / 2.f};
+        glyph.char_code = character.tex_code;
+
+        //! glyphs on different atlas pages end up in different batches
+        auto page_it = std::find_if(m_glyph_run.pages.begin(), m_glyph_run.pages.end(), [&character](auto &page)
+                                    { return page.first == character.texture_id; });
+        if (page_it == m_glyph_run.pages.end())
+        {
+            page_it = m_glyph_run.pages.insert(page_it, {character.texture_id, {}});
+        }
+        page_it->second.push_back(glyph);
 
-    auto lowest_pos_char =
-        *std::min_element(m_text.begin(), m_text.end(), [this](auto c1, auto c2)
-                          {
-        auto car1 = m_font->m_characters.at(c1);
-        auto car2 = m_font->m_characters.at(c2);
-        return car1.bb.pos_y < car2.bb.pos_y; });
+        line_pos.x += shaped_glyph.x_advance * text_scale.x;
 
-    auto lowest_c = m_font->m_characters.at(lowest_pos_char);
-    return -(lowest_c.bb.pos_y) * getScale().y;
+        lowest_y = std::min(lowest_y, character.bb.pos_y);
+        if (character.bb.pos_y + character.bb.height > highest_top)
+        {
+            highest_top = character.bb.pos_y + character.bb.height;
+            highest_glyph_height = character.bb.height;
+        }
+    }
+    m_font->uploadPendingGlyphs();
+
+    auto &bounding_box = m_glyph_run.bounding_box;
+    bounding_box.width = line_pos.x - getPosition().x;
+    bounding_box.height = (highest_glyph_height - lowest_y) * text_scale.y;
+    bounding_box.pos_y -= (-lowest_y) * text_scale.y;
+    m_glyph_run.depth_under_line = -lowest_y * text_scale.y;
 }
 
-//! \todo I should probably cache these results since they are unlikely to change
-Rect<float> Text::getBoundingBox() const
+float largestCharacterHeight(Font &font)
 {
-    if (m_text.empty())
+    int max_height = 0;
+    font.m_characters.forEach([&max_height](int /*code*/, const Character &glyph)
+                              { max_height = std::max(max_height, glyph.size.y); });
+    return (float)(max_height);
+}
+
+float Text::getCursorPosition(std::size_t cursor_pos)
+{
+    float pos = getPosition().x;
+    for (auto &shaped_glyph : getGlyphRun().shaped_glyphs)
     {
-        return {getPosition().x, getPosition().y, 0, 0};
+        if (shaped_glyph.cluster < cursor_pos)
+        {
+            pos += shaped_glyph.x_advance * getScale().x;
+        }
     }
+    return pos;
+}
+
+std::size_t Text::getCursor(float query_pos)
+{
 
-    //     // ! find dimensions of the text
-    auto largest_pos_char =
-        *std::max_element(m_text.begin(), m_text.end(), [this](auto c1, auto c2)
-                          {
-        auto car1 = m_font->m_characters.at(c1);
-        auto car2 = m_font->m_characters.at(c2);
-        return car1.bb.pos_y + car1.bb.height < car2.bb.pos_y + car2.bb.height; });
-    auto lowest_pos_char =
-        *std::min_element(m_text.begin(), m_text.end(), [this](auto c1, auto c2)
-                          {
-        auto car1 = m_font->m_characters.at(c1);
-        auto car2 = m_font->m_characters.at(c2);
-        return car1.bb.pos_y < car2.bb.pos_y; });
-
-    auto largest_c = m_font->m_characters.at(largest_pos_char);
-    auto lowest_c = m_font->m_characters.at(lowest_pos_char);
-    float text_height = largest_c.bb.height - lowest_c.bb.pos_y;
-
-    Rect<float> bounding_box;
-    text_height *= getScale().y;
-    bounding_box.pos_y = getPosition().y;
-    bounding_box.height = text_height;
-
-    bounding_box.pos_y -= (-lowest_c.bb.pos_y) * getScale().y;
-
-    bounding_box.width = 0;
-    for (auto c : m_text)
+    float char_pos = getPosition().x;
+
+    for (auto &shaped_glyph : getGlyphRun().shaped_glyphs)
     {
-        auto character = m_font->m_characters.at(c);
-        bounding_box.width += (character.advance >> 6) * getScale().x;
+        if (query_pos <= char_pos)
+        {
+            return shaped_glyph.cluster;
+        }
+        char_pos += shaped_glyph.x_advance * getScale().x;
     }
-    bounding_box.pos_x = getPosition().x;
-    // std::cout << "TEXT: " << getText() << " BB:\n" << bounding_box.height<< " \nbelow: " << (lowest_c.size.y - lowest_c.bearing.y) * getScale().y << std::endl;
 
-    return bounding_box;
+    return m_text.size();
 }
+namespace
+{
+//! \brief calls \p on_paragraph with every part of \p text separated by '\n'
+template <class Function>
+void forEachParagraph(std::string_view text, Function on_paragraph)
+{
+    std::size_t start = 0;
+    while (true)
+    {
+        auto end = text.find('\n', start);
+        on_paragraph(text.substr(start, end - start));
+        if (end == std::string_view::npos)
+        {
+            return;
+        }
+        start = end + 1;
+    }
+}
+} // namespace
 
-float largestCharacterHeight(Font &font)
+MultiLineText::MultiLineText()
 {
-    auto max_el_it = std::max_element(font.m_characters.begin(), font.m_characters.end(), [](auto &character1, auto &character2)
-                                      {
-        Character& glyph1 = character1.second;
-        Character& glyph2 = character2.second;
-        return glyph1.size.y < glyph2.size.y; });
-    return (float)(max_el_it->second.size.y);
 }
 
 void MultiLineText::drawInto2(Renderer &canvas)
 {
-    m_line_size = m_text_scale * p_font->getLineHeight();
+    drawLines(canvas, [&canvas](Text &t_word)
+              { canvas.drawText(t_word); });
+}
+
+void MultiLineText::drawInto(Renderer &canvas)
+{
+    drawLines(canvas, [&canvas](Text &t_word)
+              { canvas.drawText2(t_word); });
+}
 
-    utils::Vector2f word_pos = m_page_position + Vec2{m_page_padding.x, -m_page_padding.y} - utils::Vector2f{0.f, m_line_size};
-    auto drawWordAndMoveCursor = [&, this](Text &t_word)
+//! \brief positions and draws words of lines, which are inside the clip rect (or the view of the \p canvas)
+//! \param canvas
+//! \param draw_word    called with every visible word after it was positioned
+template <class DrawFunction>
+void MultiLineText::drawLines(Renderer &canvas, DrawFunction draw_word)
+{
+    if (!p_font)
     {
-        auto b_box = t_word.getBoundingBox();
-        if (word_pos.x + b_box.width > rightTextBorder()) //! line overflow -> newline
-        {
-            word_pos.x = leftTextBorder();
-            word_pos.y -= m_line_size + m_line_spacing;
-        }
+        return;
+    }
+    updateLayout();
 
-        t_word.setPosition(word_pos);
-        canvas.drawText(t_word);
-        word_pos.x += b_box.width + m_word_spacing;
+    auto is_visible = [&canvas, this](const Rect<float> &rect)
+    {
+        return m_clip_to_rect ? rect.intersects(m_clip_rect) : canvas.m_view.intersects(rect);
     };
 
-    //! iterate through words
-    std::size_t start_pos = 0;
-    std::size_t next_pos = m_text.find_first_of(' ');
-    Text t_word = Text{m_text.substr(start_pos, next_pos - start_pos + 1)};
-    t_word.setFont(p_font);
-    t_word.setScale(m_text_scale, m_text_scale); //! fuck the flipping, fuck OpenGL coordinates, and fuck me
+    const float line_height = m_line_size + m_line_spacing;
+    const float word_gap = m_space_width + m_word_spacing;
+    const float text_width = rightTextBorder() - leftTextBorder();
+    const float align_factor = m_alignment == TextAlign::Left ? 0.f : (m_alignment == TextAlign::Center ? 0.5f : 1.f);
 
-    while (next_pos != std::string::npos)
+    //! line_y is the baseline, glyphs are expected to stay within one line size above and below it
+    float line_y = m_page_position.y - m_page_padding.y - m_line_size;
+    for (auto &paragraph : m_paragraphs)
     {
-        t_word.setText(m_text.substr(start_pos, next_pos - start_pos + 1));
-
-        drawWordAndMoveCursor(t_word);
+        const auto lines_count = paragraph.line_starts.size();
+        float paragraph_bottom = line_y - (lines_count - 1) * line_height - m_line_size;
+        if (!is_visible({leftTextBorder(), paragraph_bottom, text_width, line_y + m_line_size - paragraph_bottom}))
+        {
+            line_y -= lines_count * line_height;
+            continue;
+        }
 
-        start_pos = next_pos + 1;
-        next_pos = m_text.find_first_of(' ', start_pos + 1);
+        for (std::size_t line = 0; line < lines_count; ++line, line_y -= line_height)
+        {
+            if (!is_visible({leftTextBorder(), line_y - m_line_size, text_width, 2.f * m_line_size}))
+            {
+                continue;
+            }
+
+            float word_x = leftTextBorder() + std::max(0.f, text_width - paragraph.line_widths[line]) * align_factor;
+            auto first_word = paragraph.line_starts[line];
+            auto end_word = line + 1 < lines_count ? paragraph.line_starts[line + 1] : paragraph.words.size();
+            for (auto word_ind = first_word; word_ind < end_word; ++word_ind)
+            {
+                auto &t_word = paragraph.words[word_ind];
+                t_word.setPosition(word_x, line_y);
+                draw_word(t_word);
+                word_x += paragraph.word_widths[word_ind] + word_gap;
+            }
+        }
     }
-
-    //! draw the last word
-    t_word.setText(m_text.substr(start_pos));
-    drawWordAndMoveCursor(t_word);
-
-    m_page_height = m_page_padding.y + m_line_size + m_line_spacing - (word_pos.y - m_page_position.y);
 }
 
-void MultiLineText::drawInto(Renderer &canvas)
+//! \brief recomputes words and line breaks of paragraphs which changed since the last call
+//!  is called automatically when drawing
+void MultiLineText::updateLayout()
 {
+    if (!p_font)
+    {
+        return;
+    }
+    if (m_layout_font_generation != p_font->getGeneration())
+    {
+        m_layout_font_generation = p_font->getGeneration();
+        invalidateWords();
+    }
+    if (m_space_width < 0.f)
+    {
+        float space_advance = 0.f;
+        for (auto &shaped_glyph : p_font->shape(L" "))
+        {
+            space_advance += shaped_glyph.x_advance;
+        }
+        m_space_width = space_advance * m_text_scale;
+    }
     m_line_size = m_text_scale * p_font->getLineHeight();
 
-    utils::Vector2f word_pos = m_page_position + Vec2{m_page_padding.x, -m_page_padding.y} - utils::Vector2f{0.f, m_line_size};
-    auto drawWordAndMoveCursor = [&, this](Text &t_word)
+    std::size_t lines_count = 0;
+    for (auto &paragraph : m_paragraphs)
     {
-        auto b_box = t_word.getBoundingBox();
-        if (word_pos.x + b_box.width > rightTextBorder()) //! line overflow -> newline
+        if (!paragraph.words_valid)
+        {
+            updateWords(paragraph);
+        }
+        if (!paragraph.breaks_valid)
         {
-            word_pos.x = leftTextBorder();
-            word_pos.y -= m_line_size + m_line_spacing;
+            breakLines(paragraph);
         }
+        lines_count += paragraph.line_starts.size();
+    }
+    m_page_height = 2.f * m_page_padding.y + lines_count * (m_line_size + m_line_spacing);
+}
 
-        t_word.setPosition(word_pos);
-        canvas.drawText2(t_word);
-        word_pos.x += b_box.width + m_word_spacing;
-    };
+//! \brief splits the \p paragraph into words and shapes them
+void MultiLineText::updateWords(Paragraph &paragraph)
+{
+    paragraph.words.clear();
+    paragraph.word_widths.clear();
 
-    //! iterate through words
+    std::string_view text = paragraph.text; //! words are views into it, so they are not copied before decoding
     std::size_t start_pos = 0;
-    std::size_t next_pos = m_text.find_first_of(' ');
-    Text t_word = Text{m_text.substr(start_pos, next_pos - start_pos + 1)};
-    t_word.setFont(p_font);
-    t_word.setScale(m_text_scale, m_text_scale); //! fuck the flipping, fuck OpenGL coordinates, and fuck me
-    t_word.m_edge_color = {255, 255, 255, 255};
-    t_word.m_glow_color = {0, 0, 0, 0};
-
-    while (next_pos != std::string::npos)
+    while (true)
     {
-        t_word.setText(m_text.substr(start_pos, next_pos - start_pos + 1));
-        drawWordAndMoveCursor(t_word);
-
+        auto next_pos = text.find(' ', start_pos);
+        auto word = text.substr(start_pos, next_pos - start_pos);
+        if (!word.empty())
+        {
+            auto &t_word = paragraph.words.emplace_back(word);
+            t_word.setFont(p_font);
+            t_word.setScale(m_text_scale, m_text_scale);
+            t_word.m_edge_color = {255, 255, 255, 255};
+            t_word.m_glow_color = {0, 0, 0, 0};
+            paragraph.word_widths.push_back(t_word.getTextWidth());
+        }
+        if (next_pos == std::string_view::npos)
+        {
+            break;
+        }
         start_pos = next_pos + 1;
+    }
 
-        next_pos = m_text.find_first_of(' ', start_pos + 1);
-        auto next_newline = m_text.find_first_of('\n', start_pos + 1);
-        if (next_newline < next_pos)
-        {
-            t_word.setText(m_text.substr(start_pos, next_newline - start_pos));
-            drawWordAndMoveCursor(t_word);
+    paragraph.words_valid = true;
+    paragraph.breaks_valid = false;
+}
+
+//! \brief chooses the first word of every line of the \p paragraph
+//!  a word wider than the page gets a line of its own, an empty paragraph still takes one line
+void MultiLineText::breakLines(Paragraph &paragraph) const
+{
+    const auto &widths = paragraph.word_widths;
+    const auto words_count = widths.size();
+    const float word_gap = m_space_width + m_word_spacing;
+    const float text_width = rightTextBorder() - leftTextBorder();
+
+    paragraph.line_starts.clear();
+    paragraph.line_widths.clear();
+    paragraph.breaks_valid = true;
 
-            word_pos.y -= m_line_size + m_line_spacing;
-            word_pos.x = leftTextBorder();
-            start_pos = next_newline + 1;
-            next_pos = m_text.find_first_of(' ', start_pos + 1);
+    if (m_line_breaking == LineBreaking::Greedy || words_count == 0)
+    {
+        paragraph.line_starts.push_back(0);
+        float line_width = words_count > 0 ? widths[0] : 0.f;
+        for (std::size_t word_ind = 1; word_ind < words_count; ++word_ind)
+        {
+            if (line_width + word_gap + widths[word_ind] > text_width) //! line overflow -> newline
+            {
+                paragraph.line_widths.push_back(line_width);
+                paragraph.line_starts.push_back(word_ind);
+                line_width = widths[word_ind];
+            }
+            else
+            {
+                line_width += word_gap + widths[word_ind];
+            }
         }
+        paragraph.line_widths.push_back(line_width);
+        return;
     }
 
-    //! draw the last word
-    t_word.setText(m_text.substr(start_pos));
-    drawWordAndMoveCursor(t_word);
+    //! cost[i] is the smallest raggedness of the words starting at i, when a line starts at i
+    //! the last line is free, so the paragraph does not get stretched to fill it
+    std::vector<float> cost(words_count + 1, std::numeric_limits<float>::max());
+    std::vector<std::size_t> line_end(words_count + 1, words_count);
+    cost[words_count] = 0.f;
+    for (std::size_t first = words_count; first-- > 0;)
+    {
+        float line_width = -word_gap;
+        for (std::size_t end = first + 1; end <= words_count; ++end)
+        {
+            line_width += word_gap + widths[end - 1];
+            if (line_width > text_width && end > first + 1)
+            {
+                break;
+            }
+            float free_space = text_width - line_width;
+            float line_cost = (end == words_count ? 0.f : free_space * free_space) + cost[end];
+            if (line_cost < cost[first])
+            {
+                cost[first] = line_cost;
+                line_end[first] = end;
+            }
+        }
+    }
 
-    m_page_height = m_page_padding.y + m_line_size + m_line_spacing - (word_pos.y - m_page_position.y);
+    for (std::size_t first = 0; first < words_count; first = line_end[first])
+    {
+        float line_width = -word_gap;
+        for (auto word_ind = first; word_ind < line_end[first]; ++word_ind)
+        {
+            line_width += word_gap + widths[word_ind];
+        }
+        paragraph.line_starts.push_back(first);
+        paragraph.line_widths.push_back(line_width);
+    }
 }
 
-float Text::getCursorPosition(std::size_t cursor_pos)
+void MultiLineText::invalidateWords()
 {
-    float pos = getPosition().x;
-    for (std::size_t text_pos = 0; text_pos < cursor_pos; ++text_pos)
+    for (auto &paragraph : m_paragraphs)
     {
-        auto character = m_font->m_characters.at(m_text.at(text_pos));
-        pos += (character.advance >> 6) * getScale().x;
+        paragraph.words_valid = false;
     }
-    return pos;
+    m_space_width = -1.f;
 }
 
-std::size_t Text::getCursor(float query_pos)
+void MultiLineText::invalidateBreaks()
 {
+    for (auto &paragraph : m_paragraphs)
+    {
+        paragraph.breaks_valid = false;
+    }
+}
 
-    float char_pos = getPosition().x;
+//! \brief replaces the whole text, only paragraphs which differ from the current ones are laid out again
+//! \param text     paragraphs are separated by '\n'
+void MultiLineText::setText(std::string_view text)
+{
+    std::size_t paragraph_ind = 0;
+    forEachParagraph(text, [&paragraph_ind, this](std::string_view paragraph_text)
+                     {
+        if (paragraph_ind == m_paragraphs.size())
+        {
+            m_paragraphs.emplace_back();
+        }
+        auto &paragraph = m_paragraphs[paragraph_ind++];
+        if (paragraph.text != paragraph_text)
+        {
+            paragraph.text = paragraph_text;
+            paragraph.words_valid = false;
+        } });
+    m_paragraphs.resize(paragraph_ind);
+}
 
-    for (std::size_t text_pos = 0; text_pos < m_text.size(); ++text_pos)
+//! \returns the whole text with paragraphs joined by '\n'
+std::string MultiLineText::getText() const
+{
+    std::string text;
+    for (std::size_t paragraph_ind = 0; paragraph_ind < m_paragraphs.size(); ++paragraph_ind)
     {
-        if (query_pos <= char_pos)
+        if (paragraph_ind > 0)
         {
-            return text_pos;
+            text += '\n';
         }
-        auto character = m_font->m_characters.at(m_text.at(text_pos));
-        char_pos += (character.advance >> 6) * getScale().x;
+        text += m_paragraphs[paragraph_ind].text;
     }
+    return text;
+}
 
-    return m_text.size();
+//! \brief appends \p text to the end, only the last paragraph and the new ones are laid out
+//! \param text     may contain '\n', which starts a new paragraph
+void MultiLineText::appendText(std::string_view text)
+{
+    bool is_first = true;
+    forEachParagraph(text, [&is_first, this](std::string_view paragraph_text)
+                     {
+        if (!is_first)
+        {
+            m_paragraphs.emplace_back();
+        }
+        is_first = false;
+        if (!paragraph_text.empty())
+        {
+            auto &paragraph = m_paragraphs.back();
+            paragraph.text += paragraph_text;
+            paragraph.words_valid = false;
+        } });
 }
-MultiLineText::MultiLineText()
+
+//! \brief replaces a single paragraph, the others keep their layout
+//! \param index    index of the paragraph, missing paragraphs are added as empty ones
+//! \param text     when it contains '\n' the paragraph gets split and the rest is inserted after it
+void MultiLineText::setParagraph(std::size_t index, std::string_view text)
 {
+    if (index >= m_paragraphs.size())
+    {
+        m_paragraphs.resize(index + 1);
+    }
+
+    auto paragraph_ind = index;
+    forEachParagraph(text, [&paragraph_ind, index, this](std::string_view paragraph_text)
+                     {
+        if (paragraph_ind != index)
+        {
+            m_paragraphs.insert(m_paragraphs.begin() + paragraph_ind, Paragraph{});
+        }
+        auto &paragraph = m_paragraphs[paragraph_ind++];
+        if (paragraph.text != paragraph_text)
+        {
+            paragraph.text = paragraph_text;
+            paragraph.words_valid = false;
+        } });
 }
 
-void MultiLineText::setText(std::string text)
+std::size_t MultiLineText::getParagraphsCount() const
 {
-    m_text = text;
+    return m_paragraphs.size();
+}
+
+std::size_t MultiLineText::getLinesCount()
+{
+    updateLayout();
+    std::size_t lines_count = 0;
+    for (auto &paragraph : m_paragraphs)
+    {
+        lines_count += paragraph.line_starts.size();
+    }
+    return lines_count;
 }
 
 void MultiLineText::setPosition(utils::Vector2f position)
@@ -317,26 +599,41 @@ utils::Vector2f MultiLineText::getPosition() const
 
 void MultiLineText::setPageWidth(float width)
 {
-    m_page_width = width;
+    if (width != m_page_width)
+    {
+        m_page_width = width;
+        invalidateBreaks();
+    }
 }
+
 float MultiLineText::getPageWidth() const
 {
     return m_page_width;
 }
 
-float MultiLineText::getPageHeight() const
+//! \returns height of the page containing all lines of the text
+float MultiLineText::getPageHeight()
 {
+    updateLayout();
     return m_page_height;
 }
 
 void MultiLineText::setPadding(utils::Vector2f padding)
 {
+    if (padding.x != m_page_padding.x)
+    {
+        invalidateBreaks();
+    }
     m_page_padding = padding;
 }
 
 void MultiLineText::setWordSpacing(float spacing)
 {
-    m_word_spacing = spacing;
+    if (spacing != m_word_spacing)
+    {
+        m_word_spacing = spacing;
+        invalidateBreaks();
+    }
 }
 
 void MultiLineText::setLineSpacing(float spacing)
@@ -346,12 +643,48 @@ void MultiLineText::setLineSpacing(float spacing)
 
 void MultiLineText::setScale(float scale)
 {
-    m_text_scale = scale;
+    if (scale != m_text_scale)
+    {
+        m_text_scale = scale;
+        invalidateWords();
+    }
 }
 
 void MultiLineText::setFont(Font *font)
 {
-    p_font = font;
+    if (font != p_font)
+    {
+        p_font = font;
+        m_layout_font_generation = font ? font->getGeneration() : 0;
+        invalidateWords();
+    }
+}
+
+void MultiLineText::setAlignment(TextAlign alignment)
+{
+    m_alignment = alignment;
+}
+
+void MultiLineText::setLineBreaking(LineBreaking line_breaking)
+{
+    if (line_breaking != m_line_breaking)
+    {
+        m_line_breaking = line_breaking;
+        invalidateBreaks();
+    }
+}
+
+//! \brief only lines intersecting \p clip_rect are drawn
+void MultiLineText::setClipRect(Rect<float> clip_rect)
+{
+    m_clip_rect = clip_rect;
+    m_clip_to_rect = true;
+}
+
+//! \brief lines are drawn when they intersect the view of the canvas (the default)
+void MultiLineText::disableClipping()
+{
+    m_clip_to_rect = false;
 }
 
 float MultiLineText::leftTextBorder() const
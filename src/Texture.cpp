@@ -1,11 +1,50 @@
 #include "Texture.h"
 
 #include "IncludesGl.h"
+#include "AssetPack.h"
+#include "TextureResidency.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../external/stbimage/stb_image.h"
 
+#include <algorithm>
 #include <cassert>
+#include <bit>
+#include <fstream>
+
+//! \brief dirty flags of textures with MipmapGeneration::Lazy, keyed by their OpenGL handles
+//!  (handles are used, because sprites and batches know only those)
+static std::unordered_map<GLuint, bool> &lazyMipmapsDirtyFlags()
+{
+    static std::unordered_map<GLuint, bool> dirty_flags;
+    return dirty_flags;
+}
+
+//! \brief averages 2x2 blocks of 8-bit \p pixels
+//! \returns image of size max(width/2, 1) x max(height/2, 1)
+static std::vector<unsigned char> downsampleImage(const std::vector<unsigned char> &pixels, int width, int height, int channels_count)
+{
+    int new_width = std::max(width / 2, 1);
+    int new_height = std::max(height / 2, 1);
+    std::vector<unsigned char> result(static_cast<std::size_t>(new_width) * new_height * channels_count);
+    for (int y = 0; y < new_height; ++y)
+    {
+        int y0 = std::min(2 * y, height - 1);
+        int y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < new_width; ++x)
+        {
+            int x0 = std::min(2 * x, width - 1);
+            int x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < channels_count; ++c)
+            {
+                int sum = pixels[(y0 * width + x0) * channels_count + c] + pixels[(y0 * width + x1) * channels_count + c] +
+                          pixels[(y1 * width + x0) * channels_count + c] + pixels[(y1 * width + x1) * channels_count + c];
+                result[(y * new_width + x) * channels_count + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
 
 //! \brief constructs the texture from an \p image_file
 //! \param image_file
@@ -33,6 +72,7 @@ Texture::Texture(int width, int height, TextureOptions options)
 
 Texture::~Texture()
 {
+    lazyMipmapsDirtyFlags().erase(m_texture_handle);
     glDeleteTextures(1, &m_texture_handle);
     glCheckError();
 }
@@ -114,15 +154,7 @@ void Texture::loadFromBytes(const unsigned char *buffer, std::size_t size, Textu
 
     if (data)
     {
-        //! generate name and bind texture
-        initialize(options);
-        glCheckError();
-        auto format = channels_count == 4 ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
-        glCheckError();
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glCheckError();
-
+        uploadImage(data, channels_count, options);
         stbi_image_free(data);
     }
     else
@@ -174,15 +206,7 @@ void Texture::loadFromFile(std::string filename, TextureOptions options)
 
     if (data)
     {
-        //! generate name and bind texture
-        initialize(options);
-        glCheckError();
-        auto format = channels_count == 4 ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
-        glCheckError();
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glCheckError();
-
+        uploadImage(data, channels_count, options);
         stbi_image_free(data);
     }
     else
@@ -201,8 +225,10 @@ void Texture::invalidate()
 //! \param options  struct containing how the texture should be created
 void Texture::initialize(TextureOptions options)
 {
-
-    glGenTextures(1, &m_texture_handle);
+    if (m_texture_handle == 0) //! reloading keeps the old handle, so that everyone using it stays valid
+    {
+        glGenTextures(1, &m_texture_handle);
+    }
     glBindTexture(GL_TEXTURE_2D, m_texture_handle);
     glCheckError();
 
@@ -216,8 +242,175 @@ void Texture::initialize(TextureOptions options)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, getGLCode(options.min_param));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, getGLCode(options.mag_param));
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, options.mipmap_levels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, getMipmapLevelsCount());
+    glCheckError();
+
+    m_pending_levels.clear();
+    m_streamed_level = 0;
+    lazyMipmapsDirtyFlags().erase(m_texture_handle);
+    if (options.mipmap_generation == MipmapGeneration::Lazy)
+    {
+        lazyMipmapsDirtyFlags()[m_texture_handle] = false;
+    }
+}
+
+//! \brief uploads decoded image \p data into the base level and creates mipmaps as given by \p options
+//! \param data             8-bit pixels of size m_width x m_height
+//! \param channels_count   3 for RGB and 4 for RGBA images
+//! \param options
+void Texture::uploadImage(const unsigned char *data, int channels_count, TextureOptions options)
+{
+    //! images are always uploaded as 8-bit RGBA/RGB, so remember that instead of the requested format
+    m_options = options;
+    m_options.format = TextureFormat::RGBA;
+    m_options.internal_format = TextureFormat::RGBA;
+    m_options.data_type = TextureDataTypes::UByte;
+    m_channels_count = channels_count;
+
+    //! generate name and bind texture
+    initialize(options);
+    glCheckError();
+    auto format = channels_count == 4 ? GL_RGBA : GL_RGB;
+
+    if (options.mipmap_generation == MipmapGeneration::Streamed && getMipmapLevelsCount() > 0)
+    {
+        //! keep the whole chain on the CPU and upload only the coarsest level now
+        m_pending_levels.push_back({data, data + static_cast<std::size_t>(m_width) * m_height * channels_count});
+        for (int level = 1; level <= getMipmapLevelsCount(); ++level)
+        {
+            m_pending_levels.push_back(downsampleImage(m_pending_levels.back(), std::max(m_width >> (level - 1), 1),
+                                                       std::max(m_height >> (level - 1), 1), channels_count));
+        }
+
+        m_streamed_level = getMipmapLevelsCount();
+        int width = std::max(m_width >> m_streamed_level, 1);
+        int height = std::max(m_height >> m_streamed_level, 1);
+        glTexImage2D(GL_TEXTURE_2D, m_streamed_level, format, width, height, 0, format, GL_UNSIGNED_BYTE,
+                     m_pending_levels.back().data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_streamed_level);
+        m_pending_levels.pop_back();
+        glCheckError();
+        return;
+    }
+
+    glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
     glCheckError();
+    if (options.mipmap_generation == MipmapGeneration::Eager && getMipmapLevelsCount() > 0)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glCheckError();
+    }
+    else
+    {
+        allocateMipmapLevels(format, format, GL_UNSIGNED_BYTE);
+        markMipmapsDirty();
+    }
+}
+
+//! \brief allocates storage of all mipmap levels without computing them (so that the texture is complete)
+void Texture::allocateMipmapLevels(GLint internal_format, GLenum format, GLenum data_type)
+{
+    for (int level = 1; level <= getMipmapLevelsCount(); ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, internal_format,
+                     std::max(m_width >> level, 1), std::max(m_height >> level, 1), 0,
+                     format, data_type, NULL);
+    }
+    glCheckError();
+}
+
+//! \returns number of levels besides the base level which the texture has
+int Texture::getMipmapLevelsCount() const
+{
+    if (m_options.mipmap_generation == MipmapGeneration::None || m_width <= 0 || m_height <= 0)
+    {
+        return 0;
+    }
+    int max_dimension = std::max(m_width, m_height);
+    int full_chain_levels = std::bit_width(static_cast<unsigned int>(max_dimension)) - 1;
+    return std::clamp(m_options.mipmap_levels, 0, full_chain_levels);
+}
+
+//! \brief computes all mipmap levels from the base level right now
+void Texture::generateMipmaps()
+{
+    if (getMipmapLevelsCount() == 0 || isStreaming())
+    {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_texture_handle);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glCheckError();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    auto &dirty_flags = lazyMipmapsDirtyFlags();
+    if (dirty_flags.contains(m_texture_handle))
+    {
+        dirty_flags.at(m_texture_handle) = false;
+    }
+}
+
+//! \brief tells a Lazy texture that its base level changed, so mipmaps have to be computed before they are used
+void Texture::markMipmapsDirty()
+{
+    auto &dirty_flags = lazyMipmapsDirtyFlags();
+    if (dirty_flags.contains(m_texture_handle))
+    {
+        dirty_flags.at(m_texture_handle) = true;
+    }
+}
+
+//! \returns true if some levels of a Streamed texture still wait for upload
+bool Texture::isStreaming() const
+{
+    return m_streamed_level > 0;
+}
+
+//! \brief uploads the next finer level of a Streamed texture
+//! \returns true if a level was uploaded, false if the texture is already complete
+bool Texture::streamNextLevel()
+{
+    if (!isStreaming())
+    {
+        return false;
+    }
+
+    m_streamed_level--;
+    auto format = m_channels_count == 4 ? GL_RGBA : GL_RGB;
+    glBindTexture(GL_TEXTURE_2D, m_texture_handle);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, m_streamed_level, format,
+                 std::max(m_width >> m_streamed_level, 1), std::max(m_height >> m_streamed_level, 1), 0,
+                 format, GL_UNSIGNED_BYTE, m_pending_levels.back().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_streamed_level);
+    glCheckError();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_pending_levels.pop_back();
+    if (m_pending_levels.empty())
+    {
+        m_pending_levels.shrink_to_fit();
+    }
+    return true;
+}
+
+//! \brief generates mipmaps of a texture created with MipmapGeneration::Lazy if its base level changed since the last time
+//!  it is called by the Renderer whenever it draws a sprite minified, other textures are ignored
+//! \param texture_handle   OpenGL handle of the texture
+void requestMipmaps(GLuint texture_handle)
+{
+    auto &dirty_flags = lazyMipmapsDirtyFlags();
+    auto it = dirty_flags.find(texture_handle);
+    if (it == dirty_flags.end() || !it->second)
+    {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture_handle);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glCheckError();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    it->second = false;
 }
 
 //! \brief creates the texture with dimensions \p width x \p height and \p options
@@ -235,12 +428,8 @@ void Texture::create(int width, int height, TextureOptions options)
                  getGLCode(options.format),
                  getGLCode(options.data_type),
                  NULL);
-
-                 if(options.mipmap_levels > 0)
-                 {
-                     glGenerateMipmap(GL_TEXTURE_2D);
-
-                 }
+    //! there is nothing to filter in an empty texture, so the levels are just allocated
+    allocateMipmapLevels(getGLCode(options.internal_format), getGLCode(options.format), getGLCode(options.data_type));
     glCheckError();
 }
 
@@ -267,6 +456,59 @@ GLuint Texture::getHandle() const
     return m_texture_handle;
 }
 
+//! \brief reads whole file at \p filename (from assets on Android)
+static std::vector<unsigned char> readFileBytes(const std::string &filename)
+{
+#ifdef __ANDROID__
+    SDL_RWops *rw = SDL_RWFromFile(filename.c_str(), "rb");
+    if (!rw)
+    {
+        throw std::runtime_error("Failed to open texture " + filename + ": " + SDL_GetError());
+    }
+
+    std::vector<unsigned char> bytes(SDL_RWsize(rw));
+    auto read_bytes = SDL_RWread(rw, bytes.data(), 1, bytes.size());
+    SDL_RWclose(rw);
+    if (read_bytes != bytes.size())
+    {
+        throw std::runtime_error("Failed to read texture " + filename);
+    }
+    return bytes;
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open texture " + filename);
+    }
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+#endif
+}
+
+//! \brief FNV-1a hash of the encoded image in \p buffer together with the options it is created with
+static std::uint64_t hashContent(const unsigned char *buffer, std::size_t size, const TextureOptions &opt)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](std::uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        add(buffer[i]);
+    }
+    add(static_cast<std::uint64_t>(opt.format));
+    add(static_cast<std::uint64_t>(opt.internal_format));
+    add(static_cast<std::uint64_t>(opt.data_type));
+    add(static_cast<std::uint64_t>(opt.mag_param));
+    add(static_cast<std::uint64_t>(opt.min_param));
+    add(static_cast<std::uint64_t>(opt.wrap_x));
+    add(static_cast<std::uint64_t>(opt.wrap_y));
+    add(static_cast<std::uint64_t>(opt.mipmap_levels));
+    add(static_cast<std::uint64_t>(opt.mipmap_generation));
+    return hash;
+}
+
 //! \brief adds texture into the holder under id \p texture_name
 //! \param texture_name our id of the texture
 //! \param texture
@@ -283,6 +525,11 @@ bool TextureHolder::add(std::string texture_name, Texture &texture)
     return true;
 }
 
+//! \brief reads the texture at \p texture_file_path and adds it into the holder under id \p texture_name
+//!  if the same file content with the same \p opt was already added, the existing texture is shared
+//! \param texture_name our id of the texture
+//! \param texture_file_path    path to the image file
+//! \returns true if no texture of this name exists othrewise return false;
 bool TextureHolder::add(std::string texture_name, std::filesystem::path texture_file_path, TextureOptions opt)
 {
     if (m_textures.count(texture_name) != 0)
@@ -290,8 +537,14 @@ bool TextureHolder::add(std::string texture_name, std::filesystem::path texture_
         return false;
     }
 
-    auto tex = std::make_shared<Texture>();
-    tex->loadFromFile(texture_file_path.string(), opt);
+    auto bytes = readFileBytes(texture_file_path.string());
+    bool is_new = false;
+    auto tex = findOrLoad(bytes.data(), bytes.size(), opt, is_new);
+    if (is_new)
+    {
+        TextureResidency::instance().track(tex, [file = texture_file_path.string(), opt](Texture &texture)
+                                           { texture.loadFromFile(file, opt); });
+    }
     m_textures[texture_name] = std::move(tex);
     return true;
 }
@@ -305,6 +558,9 @@ bool TextureHolder::add(std::string texture_name, std::string texture_filename,
     return add(texture_name, m_resources_path / texture_filename, opt);
 }
 
+//! \brief decodes the texture from an encoded image in \p buffer and adds it under id \p texture_name
+//!  if the same bytes with the same \p opt were already added, the existing texture is shared
+//! \returns true if no texture of this name exists othrewise return false;
 bool TextureHolder::add(std::string texture_name, const unsigned char *buffer, std::size_t size, TextureOptions opt)
 {
     if (m_textures.count(texture_name) != 0)
@@ -312,16 +568,73 @@ bool TextureHolder::add(std::string texture_name, const unsigned char *buffer, s
         return false;
     }
 
-    auto tex = std::make_shared<Texture>();
-    tex->loadFromBytes(buffer, size, opt);
+    bool is_new = false;
+    m_textures[texture_name] = findOrLoad(buffer, size, opt, is_new);
+    return true;
+}
+
+//! \brief decodes the texture directly from the bytes of \p entry_name in a mapped \p pack
+//!  the texture may get evicted by TextureResidency and reloaded from the \p pack, so the pack has to stay open
+//! \param texture_name our id of the texture
+//! \param pack         opened asset pack
+//! \param entry_name   name of the image inside the pack
+//! \returns true if the entry exists and no texture of this name exists, otherwise returns false;
+bool TextureHolder::add(std::string texture_name, const AssetPack &pack, const std::string &entry_name, TextureOptions opt)
+{
+    auto bytes = pack.get(entry_name);
+    if (bytes.empty() || m_textures.count(texture_name) != 0)
+    {
+        return false;
+    }
+
+    bool is_new = false;
+    auto tex = findOrLoad(bytes.data(), bytes.size(), opt, is_new);
+    if (is_new)
+    {
+        TextureResidency::instance().track(tex, [&pack, entry_name, opt](Texture &texture)
+                                           {
+            auto bytes = pack.get(entry_name);
+            texture.loadFromBytes(bytes.data(), bytes.size(), opt); });
+    }
     m_textures[texture_name] = std::move(tex);
     return true;
 }
 
+//! \brief looks for a texture decoded from the same bytes with the same options, if there is none, decodes a new one
+//! \param buffer   encoded image
+//! \param size     size of the \p buffer in bytes
+//! \param opt
+//! \param is_new   is set to true if a new texture was created
+//! \returns the shared texture
+std::shared_ptr<Texture> TextureHolder::findOrLoad(const unsigned char *buffer, std::size_t size, const TextureOptions &opt, bool &is_new)
+{
+    auto key = hashContent(buffer, size, opt);
+    auto it = m_content_cache.find(key);
+    if (it != m_content_cache.end() && it->second.size == size)
+    {
+        if (auto cached = it->second.texture.lock())
+        {
+            is_new = false;
+            return cached;
+        }
+    }
+
+    auto tex = std::make_shared<Texture>();
+    tex->loadFromBytes(buffer, size, opt);
+    m_content_cache[key] = {tex, size};
+    is_new = true;
+    return tex;
+}
+
+//! \returns texture stored under \p name (reloaded if it was evicted) or nullptr if there is none
 std::shared_ptr<Texture> TextureHolder::get(std::string name) const
 {
     if (m_textures.count(name) > 0)
-        return m_textures.at(name);
+    {
+        auto &texture = m_textures.at(name);
+        TextureResidency::instance().markUsed(texture->getHandle());
+        return texture;
+    }
 
     return nullptr;
 }
@@ -350,8 +663,128 @@ const TextureOptions &Texture::getOptions() const
     return m_options;
 }
 
+static std::size_t bytesPerPixel(TextureFormat internal_format, TextureDataTypes data_type)
+{
+    switch (internal_format)
+    {
+    case TextureFormat::Red:
+        return data_type == TextureDataTypes::Float ? 4 : 1;
+    case TextureFormat::R8:
+        return 1;
+    case TextureFormat::RGBA16F:
+        return 8;
+    case TextureFormat::RGBA32F:
+        return 16;
+    case TextureFormat::RGBA:
+    default:
+        return 4;
+    }
+}
+
+//! \brief estimates how much GPU memory the texture occupies including all mip levels
+//! \returns number of bytes
+std::size_t Texture::getByteSize() const
+{
+    if (m_texture_handle == 0 || m_width <= 0 || m_height <= 0)
+    {
+        return 0;
+    }
+
+    int levels_count = 1 + getMipmapLevelsCount();
+
+    std::size_t pixels_count = 0;
+    for (int level = 0; level < levels_count; ++level)
+    {
+        std::size_t level_width = std::max(m_width >> level, 1);
+        std::size_t level_height = std::max(m_height >> level, 1);
+        pixels_count += level_width * level_height;
+    }
+    return pixels_count * bytesPerPixel(m_options.internal_format, m_options.data_type);
+}
+
+//! \brief releases GPU memory of the texture but keeps its handle (and size) valid
+//!  the texture samples as transparent until its data is loaded again
+void Texture::releaseStorage()
+{
+    if (m_texture_handle == 0)
+    {
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture_handle);
+    const unsigned char transparent_pixel[4] = {0, 0, 0, 0};
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent_pixel);
+    for (int level = 1; level <= getMipmapLevelsCount(); ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    m_pending_levels.clear();
+    m_streamed_level = 0;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0); //! keeps the 1x1 texture complete
+    glCheckError();
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+TextureHolder::CacheStats TextureHolder::getCacheStats() const
+{
+    CacheStats stats;
+    stats.names_count = m_textures.size();
+
+    std::unordered_map<const Texture *, std::size_t> names_per_texture;
+    for (auto &[name, texture] : m_textures)
+    {
+        names_per_texture[texture.get()]++;
+    }
+    stats.textures_count = names_per_texture.size();
+    for (auto [texture, names_count] : names_per_texture)
+    {
+        stats.bytes_saved += (names_count - 1) * texture->getByteSize();
+    }
+    return stats;
+}
+
+//! \brief uploads the next levels of textures loaded with MipmapGeneration::Streamed
+//!  should be called once per frame, so that the cost of uploading large images is spread over many frames
+//! \param max_uploads_count   maximum number of levels uploaded by this call
+//! \returns number of uploaded levels
+std::size_t TextureHolder::streamMipmaps(std::size_t max_uploads_count)
+{
+    std::size_t uploads_count = 0;
+    for (auto &[name, texture] : m_textures)
+    {
+        if (uploads_count >= max_uploads_count)
+        {
+            break;
+        }
+        if (texture->streamNextLevel())
+        {
+            uploads_count++;
+        }
+    }
+    return uploads_count;
+}
+
+//! \brief removes the name \p texture_id, the texture itself is released when no other name shares it
 void TextureHolder::erase(const std::string &texture_id)
 {
+    if (m_textures.count(texture_id) == 0)
+    {
+        return;
+    }
+
+    auto texture = m_textures.at(texture_id);
     m_textures.erase(texture_id);
+
+    bool is_shared = std::any_of(m_textures.begin(), m_textures.end(), [&texture](const auto &name_and_texture)
+                                 { return name_and_texture.second == texture; });
+    if (!is_shared)
+    {
+        TextureResidency::instance().untrack(texture->getHandle());
+    }
+    texture.reset();
+    std::erase_if(m_content_cache, [](const auto &key_and_content)
+                  { return key_and_content.second.texture.expired(); });
 }
 
@@ -0,0 +1,201 @@
+#include "TextureResidency.h"
+
+#include "Texture.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+TextureResidency &TextureResidency::instance()
+{
+    static TextureResidency residency;
+    return residency;
+}
+
+//! \brief sets maximum number of bytes resident textures may occupy on the GPU
+//! \param budget_bytes     0 means there is no limit (the default)
+void TextureResidency::setBudget(std::size_t budget_bytes)
+{
+    m_budget = budget_bytes;
+    enforceBudget();
+}
+
+std::size_t TextureResidency::getBudget() const
+{
+    return m_budget;
+}
+
+//! \brief starts tracking the \p texture, it may get evicted from now on
+//! \param texture  texture which is currently resident
+//! \param reload   function which loads the data into the texture again after eviction
+void TextureResidency::track(const std::shared_ptr<Texture> &texture, ReloadFunction reload)
+{
+    if (!texture || texture->getHandle() == 0)
+    {
+        return;
+    }
+
+    untrack(texture->getHandle()); //! handles may get reused by GL after a texture was deleted
+
+    Record record;
+    record.texture = texture;
+    record.reload = std::move(reload);
+    record.byte_size = texture->getByteSize();
+    record.last_used_frame = m_frame;
+    m_resident_bytes += record.byte_size;
+    m_records[texture->getHandle()] = std::move(record);
+
+    enforceBudget();
+}
+
+void TextureResidency::untrack(GLuint texture_handle)
+{
+    auto it = m_records.find(texture_handle);
+    if (it == m_records.end())
+    {
+        return;
+    }
+    if (it->second.resident)
+    {
+        m_resident_bytes -= it->second.byte_size;
+    }
+    m_records.erase(it);
+}
+
+bool TextureResidency::isTracked(GLuint texture_handle) const
+{
+    return m_records.contains(texture_handle);
+}
+
+//! \brief marks the texture as used in the current frame and reloads it if it was evicted
+//! \param texture_handle   OpenGL handle of the texture (untracked handles are ignored)
+void TextureResidency::markUsed(GLuint texture_handle)
+{
+    auto it = m_records.find(texture_handle);
+    if (it == m_records.end())
+    {
+        return;
+    }
+
+    auto &record = it->second;
+    record.last_used_frame = m_frame;
+    if (record.resident)
+    {
+        return;
+    }
+
+    auto texture = record.texture.lock();
+    if (!texture)
+    {
+        m_records.erase(it);
+        return;
+    }
+
+    try
+    {
+        record.reload(*texture);
+    }
+    catch (std::exception &e)
+    {
+        std::cout << "Failed to reload evicted texture: " << e.what() << "\n";
+        return;
+    }
+    record.resident = true;
+    record.byte_size = texture->getByteSize();
+    m_resident_bytes += record.byte_size;
+    m_reload_count++;
+
+    enforceBudget();
+}
+
+void TextureResidency::markUsed(const TextureArray &texture_handles)
+{
+    for (auto handle : texture_handles)
+    {
+        if (handle != 0)
+        {
+            markUsed(handle);
+        }
+    }
+}
+
+//! \brief finishes the frame and evicts textures if the budget is exceeded
+//!  Should be called once per frame (for example right after swapping the window buffers)
+void TextureResidency::endFrame()
+{
+    std::erase_if(m_records, [this](const auto &handle_and_record)
+                  {
+        const auto &record = handle_and_record.second;
+        if (!record.texture.expired())
+        {
+            return false;
+        }
+        if (record.resident)
+        {
+            m_resident_bytes -= record.byte_size;
+        }
+        return true; });
+
+    enforceBudget();
+    m_frame++;
+}
+
+std::size_t TextureResidency::getFrame() const
+{
+    return m_frame;
+}
+
+//! \brief evicts least recently used textures until at least \p bytes_to_free bytes are released
+//!  textures used in the current frame are never evicted, because they may still be drawn
+//! \param bytes_to_free
+//! \returns number of bytes actually released
+std::size_t TextureResidency::evictUnused(std::size_t bytes_to_free)
+{
+    std::vector<std::pair<std::size_t, GLuint>> candidates; //! (last used frame, handle)
+    for (auto &[handle, record] : m_records)
+    {
+        if (record.resident && record.last_used_frame < m_frame && !record.texture.expired())
+        {
+            candidates.push_back({record.last_used_frame, handle});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::size_t freed_bytes = 0;
+    for (auto [last_used_frame, handle] : candidates)
+    {
+        if (freed_bytes >= bytes_to_free)
+        {
+            break;
+        }
+        auto &record = m_records.at(handle);
+        record.texture.lock()->releaseStorage();
+        record.resident = false;
+        m_resident_bytes -= record.byte_size;
+        freed_bytes += record.byte_size;
+        m_eviction_count++;
+    }
+    return freed_bytes;
+}
+
+TextureResidency::Stats TextureResidency::getStats() const
+{
+    Stats stats;
+    stats.resident_bytes = m_resident_bytes;
+    stats.tracked_count = m_records.size();
+    stats.resident_count = std::count_if(m_records.begin(), m_records.end(),
+                                         [](const auto &handle_and_record)
+                                         { return handle_and_record.second.resident; });
+    stats.eviction_count = m_eviction_count;
+    stats.reload_count = m_reload_count;
+    return stats;
+}
+
+void TextureResidency::enforceBudget()
+{
+    if (m_budget == 0 || m_resident_bytes <= m_budget)
+    {
+        return;
+    }
+    evictUnused(m_resident_bytes - m_budget);
+}
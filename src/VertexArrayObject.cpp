@@ -31,7 +31,8 @@ VAOId makeSpriteVAO()
         makeAttribute(i.angle),
         makeAttribute(i.tex_coords),
         makeAttribute(i.tex_size),
-        makeAttribute(i.color)};
+        makeAttribute(i.color),
+        makeAttribute(i.texture_layer)};
 
     layout.vertex_attirbutes = {
         makeAttribute(utils::Vector2f{}),
@@ -0,0 +1,36 @@
+#include <AssetPack.h>
+
+#include <iostream>
+#include <string>
+
+//! usage: AssetPacker <resources directory> <output pack> [--lz4]
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: " << argv[0] << " <resources directory> <output pack> [--lz4]\n";
+        return 1;
+    }
+
+    std::filesystem::path resources_dir = argv[1];
+    std::filesystem::path pack_path = argv[2];
+    bool compress = argc > 3 && std::string{argv[3]} == "--lz4";
+
+    if (!std::filesystem::is_directory(resources_dir))
+    {
+        std::cout << "ERROR: " << resources_dir << " is not a directory!\n";
+        return 1;
+    }
+
+    AssetPackWriter writer;
+    auto file_count = writer.addDirectory(resources_dir, compress);
+    if (!writer.write(pack_path))
+    {
+        std::cout << "ERROR: could not write " << pack_path << "\n";
+        return 1;
+    }
+
+    std::cout << "packed " << file_count << " files into " << pack_path
+              << " (" << std::filesystem::file_size(pack_path) << " bytes)\n";
+    return 0;
+}
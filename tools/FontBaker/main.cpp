@@ -0,0 +1,80 @@
+#include <Font.h>
+#include <Utils/Utf8.h>
+#include <Window.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//! usage: FontBaker <font file> <output directory> <font name> [pixel size] [--normal] [--chars <utf8 text file>]
+//!  bakes printable ASCII and Latin-1 by default, --chars adds all characters found in the given file
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cout << "usage: " << argv[0]
+                  << " <font file> <output directory> <font name> [pixel size] [--normal] [--chars <utf8 text file>]\n";
+        return 1;
+    }
+
+    std::filesystem::path font_path = argv[1];
+    std::filesystem::path output_dir = argv[2];
+    std::string font_name = argv[3];
+    std::size_t pixel_size = 30;
+    FreetypeMode mode = FreetypeMode::SDF;
+    std::wstring characters;
+    for (int code = 32; code < 256; ++code)
+    {
+        if (code < 127 || code > 160)
+        {
+            characters += static_cast<wchar_t>(code);
+        }
+    }
+
+    for (int arg_ind = 4; arg_ind < argc; ++arg_ind)
+    {
+        std::string arg = argv[arg_ind];
+        if (arg == "--normal")
+        {
+            mode = FreetypeMode::Normal;
+        }
+        else if (arg == "--chars" && arg_ind + 1 < argc)
+        {
+            std::ifstream chars_file(argv[++arg_ind]);
+            std::stringstream chars_text;
+            chars_text << chars_file.rdbuf();
+            characters += utils::decodeUtf8(chars_text.str());
+        }
+        else
+        {
+            pixel_size = std::stoul(arg);
+        }
+    }
+
+    if (!std::filesystem::is_directory(output_dir))
+    {
+        std::cout << "ERROR: " << output_dir << " is not a directory!\n";
+        return 1;
+    }
+
+    Window window(100, 100); //! only provides the GL context
+    try
+    {
+        Font font(font_path, pixel_size, mode);
+        font.preload(characters);
+        if (!font.saveToFile(output_dir, font_name))
+        {
+            std::cout << "ERROR: could not write the baked font into " << output_dir << "\n";
+            return 1;
+        }
+        std::cout << "baked " << font.m_characters.size() << " glyphs into " << font.getPagesCount()
+                  << " pages: " << output_dir / (font_name + BAKED_FONT_EXTENSION) << "\n";
+    }
+    catch (std::exception &e)
+    {
+        std::cout << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
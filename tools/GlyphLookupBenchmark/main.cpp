@@ -0,0 +1,92 @@
+#include <GlyphTable.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! the lookups Font did before GlyphTable: one map for glyph data and one for the charmap index
+struct MapLookup
+{
+    std::unordered_map<int, Character> characters;
+    std::unordered_map<int, int> charcode2texcode;
+};
+
+//! \brief makes a text of \p length characters drawn from [\p first_code, \p last_code]
+static std::wstring makeText(std::size_t length, int first_code, int last_code)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(first_code, last_code);
+    std::wstring text(length, L' ');
+    for (auto &c : text)
+    {
+        c = static_cast<wchar_t>(distribution(generator));
+    }
+    return text;
+}
+
+template <class Function>
+static double nanosecondsPerGlyph(const std::wstring &text, int repetitions, Function lookup)
+{
+    long long checksum = 0;
+    auto tic = std::chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < repetitions; ++rep)
+    {
+        for (auto code : text)
+        {
+            checksum += lookup(code);
+        }
+    }
+    auto toc = std::chrono::high_resolution_clock::now();
+    volatile long long sink = checksum; //! keeps the loop from being optimized away
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(toc - tic).count() / (double(text.size()) * repetitions);
+}
+
+static void run(const std::string &name, const std::wstring &text, int repetitions)
+{
+    MapLookup maps;
+    GlyphTable table;
+    int tex_code = 0;
+    for (auto code : text)
+    {
+        if (table.contains(code))
+        {
+            continue;
+        }
+        Character character = {1, {tex_code, 0}, {10, 12}, {1, 10}, {0, -2, 10, 12}, 640};
+        character.tex_code = tex_code;
+        maps.characters[code] = character;
+        maps.charcode2texcode[code] = tex_code;
+        table.insert(code, character);
+        tex_code++;
+    }
+
+    //! same work as laying out one glyph: advance, size and charmap index
+    auto map_time = nanosecondsPerGlyph(text, repetitions, [&maps](int code)
+                                        {
+        auto character = maps.characters.at(code);
+        return (character.advance >> 6) + character.size.y + maps.charcode2texcode.at(code); });
+    auto table_time = nanosecondsPerGlyph(text, repetitions, [&table](int code)
+                                          {
+        const auto &character = *table.find(code);
+        return (character.advance >> 6) + character.size.y + character.tex_code; });
+
+    std::cout << name << " (" << tex_code << " distinct glyphs): unordered_map " << map_time
+              << " ns/glyph, GlyphTable " << table_time << " ns/glyph, speedup " << map_time / table_time << "x\n";
+}
+
+//! usage: GlyphLookupBenchmark [text length]
+int main(int argc, char **argv)
+{
+    std::size_t length = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    int repetitions = 20;
+
+    run("ASCII", makeText(length, 32, 126), repetitions);
+    run("Latin-1", makeText(length, 32, 255), repetitions);
+    run("Cyrillic", makeText(length, 0x400, 0x4FF), repetitions);
+    run("CJK", makeText(length, 0x4E00, 0x5DFF), repetitions);
+    return 0;
+}
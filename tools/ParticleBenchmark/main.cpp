@@ -0,0 +1,87 @@
+#include <ParticleArrays.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//! \brief makes \p count particles with random velocities and accelerations
+static std::vector<Particle> makeParticles(std::size_t count)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<Particle> particles;
+    particles.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        particles.emplace_back(utils::Vector2f{distribution(generator), distribution(generator)},
+                               utils::Vector2f{distribution(generator), distribution(generator)},
+                               utils::Vector2f{0.f, -10.f}, utils::Vector2f{1.f, 1.f}, Color{1, 1, 1, 1}, 1000.f);
+    }
+    return particles;
+}
+
+template <class Function>
+static double nanosecondsPerParticle(std::size_t count, int repetitions, Function step)
+{
+    auto tic = std::chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < repetitions; ++rep)
+    {
+        step();
+    }
+    auto toc = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(toc - tic).count() / (double(count) * repetitions);
+}
+
+//! usage: ParticleBenchmark [number of particles]
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    int repetitions = 50;
+    const float dt = 0.016f;
+    const Color init_color = {1, 1, 1, 1};
+    const Color final_color = {1, 0, 0, 0};
+
+    //! what Particles does: one std::function call per particle on an array of structures
+    auto aos = makeParticles(count);
+    std::function<void(Particle &, float)> updater = [&](Particle &particle, float dt)
+    {
+        particle.time += dt;
+        particle.vel += particle.acc * dt;
+        particle.pos += particle.vel * dt;
+        float ratio = std::min(std::max(particle.time / particle.life_time, 0.f), 1.f);
+        particle.color.r = init_color.r + (final_color.r - init_color.r) * ratio;
+        particle.color.g = init_color.g + (final_color.g - init_color.g) * ratio;
+        particle.color.b = init_color.b + (final_color.b - init_color.b) * ratio;
+        particle.color.a = init_color.a + (final_color.a - init_color.a) * ratio;
+    };
+    auto aos_time = nanosecondsPerParticle(count, repetitions, [&]()
+                                           {
+        for (auto &particle : aos)
+        {
+            updater(particle, dt);
+        } });
+
+    ParticleArrays soa(count);
+    for (const auto &particle : makeParticles(count))
+    {
+        soa.push(particle);
+    }
+    auto soa_time = nanosecondsPerParticle(count, repetitions, [&]()
+                                           {
+        auto spans = soa.spans();
+        particle_kernels::age(spans, dt);
+        particle_kernels::integrateEuler(spans, dt);
+        particle_kernels::interpolateColors(spans, init_color, final_color); });
+
+    //! both layouts must end up in the same state
+    auto check = soa.get(count / 2);
+    std::cout << "checksum AoS " << aos[count / 2].pos.x << ", SoA " << check.pos.x << "\n";
+
+    std::cout << count << " particles: AoS + std::function " << aos_time << " ns/particle, SoA kernels ("
+              << particle_kernels::getInstructionSet() << ") " << soa_time << " ns/particle, speedup "
+              << aos_time / soa_time << "x\n";
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <ParticleWorld.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+//! \brief fills \p world with \p emitters_count emitters of \p particles_per_emitter particles each
+//! \param interacts   particles repel and attract their neighbours and bounce off a collider (a swarm)
+static void populate(ParticleWorld &world, std::size_t emitters_count, int particles_per_emitter, bool interacts)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    for (std::size_t i = 0; i < emitters_count; ++i)
+    {
+        auto &emitter = world.addEmitter(particles_per_emitter);
+        emitter.setSpawnPos({distribution(generator) * 500.f, distribution(generator) * 500.f});
+        emitter.setLifetime(1000.f);
+        emitter.setPeriod(1000.f); //! particles are pushed below, so that all emitters start full
+        emitter.setUpdater([](const ParticleSpans &particles, float dt)
+                           {
+            for (std::size_t i = 0; i < particles.size(); ++i)
+            {
+                particles.angle[i] += 90.f * dt;
+            } });
+        if (interacts)
+        {
+            emitter.setRepulsion(200.f, 6.f);
+            emitter.setAttraction(50.f, 8.f);
+            emitter.addCollider({-100.f, -100.f, 200.f, 50.f});
+        }
+        for (int p = 0; p < particles_per_emitter; ++p)
+        {
+            utils::Vector2f pos = {0, 0};
+            if (interacts)
+            {
+                pos = {distribution(generator) * 600.f, distribution(generator) * 600.f}; //! about 8 neighbours each
+            }
+            Particle particle(pos, {distribution(generator), distribution(generator)}, {0.f, -10.f});
+            particle.life_time = 1000.f;
+            emitter.getParticles().push(particle);
+        }
+    }
+}
+
+//! \returns milliseconds per update of \p emitters_count emitters updated by \p n_threads threads
+static double millisecondsPerUpdate(std::size_t n_threads, std::size_t emitters_count, int particles_per_emitter, bool interacts,
+                                    int repetitions)
+{
+    ParticleWorld world(n_threads);
+    populate(world, emitters_count, particles_per_emitter, interacts);
+    world.update(0.016f); //! warm up
+
+    auto tic = std::chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < repetitions; ++rep)
+    {
+        world.update(0.016f);
+    }
+    auto toc = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(toc - tic).count() / repetitions;
+}
+
+static void run(const std::string &name, std::size_t emitters_count, int particles_per_emitter, bool interacts, int repetitions)
+{
+    auto max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double single_thread_time = 0.;
+    for (std::size_t n_threads = 1; n_threads <= max_threads; n_threads *= 2)
+    {
+        auto time = millisecondsPerUpdate(n_threads, emitters_count, particles_per_emitter, interacts, repetitions);
+        if (n_threads == 1)
+        {
+            single_thread_time = time;
+        }
+        std::cout << name << " (" << emitters_count << " x " << particles_per_emitter << " particles), "
+                  << n_threads << " threads: " << time << " ms/update, speedup " << single_thread_time / time << "x\n";
+    }
+}
+
+//! usage: ParticleWorldBenchmark [number of updates]
+int main(int argc, char **argv)
+{
+    int repetitions = argc > 1 ? std::stoi(argv[1]) : 50;
+
+    run("many small emitters", 500, 1000, false, repetitions);
+    run("one big emitter", 1, 500'000, false, repetitions);
+    run("interacting swarm", 1, 50'000, true, repetitions);
+    return 0;
+}